@@ -0,0 +1,124 @@
+#******************************************************************************
+# Firmware target: Teensy 3.2 / 3.1, USB Serial, 72 MHz, US English
+# (same settings as the VisualTeensy makefile)
+#******************************************************************************
+enable_language(ASM)
+
+set(TEENSY_CORE_DIR "$ENV{TEENSY_CORE_DIR}" CACHE PATH "Teensyduino cores/teensy3 directory")
+if(NOT EXISTS ${TEENSY_CORE_DIR}/mk20dx256.ld)
+  message(FATAL_ERROR "TEENSY_CORE_DIR must point at Teensyduino's cores/teensy3 (got '${TEENSY_CORE_DIR}')")
+endif()
+
+set(HOTSHOT_PROFILE speed CACHE STRING "Optimization profile: speed (-O2) or size (-Os)")
+set_property(CACHE HOTSHOT_PROFILE PROPERTY STRINGS speed size)
+option(HOTSHOT_LTO "Build the firmware with link-time optimization" ON)
+
+set(CMAKE_EXECUTABLE_SUFFIX .elf)
+
+set(FLAGS_CPU -mthumb -mcpu=cortex-m4 -fsingle-precision-constant)
+set(FLAGS_COM -g -Wall -ffunction-sections -fdata-sections -nostdlib)
+set(FLAGS_CPP -fno-exceptions -fpermissive -felide-constructors -std=gnu++14 -Wno-error=narrowing -fno-rtti)
+set(FLAGS_S -x assembler-with-cpp)
+
+if(HOTSHOT_PROFILE STREQUAL "size")
+  set(FLAGS_OPT -Os)
+  set(FLAGS_LSP --specs=nano.specs)
+elseif(HOTSHOT_PROFILE STREQUAL "speed")
+  set(FLAGS_OPT -O2)
+  set(FLAGS_LSP)
+else()
+  message(FATAL_ERROR "HOTSHOT_PROFILE must be 'speed' or 'size'")
+endif()
+
+if(HOTSHOT_LTO)
+  list(APPEND FLAGS_OPT -flto -fno-fat-lto-objects)
+  set(FLAGS_LTO_LD -fuse-linker-plugin)
+endif()
+
+# The core waits TEENSY_INIT_USB_DELAY_AFTER ms (275 by default) after starting USB,
+# before setup(); the cabinet does not need the host, so skip it (src/boot.h).
+# The TeensyThreads stack pool holds one stack per thread src/main.cpp starts.
+add_compile_definitions(
+  __MK20DX256__ TEENSYDUINO=146 ARDUINO=10807
+  F_CPU=72000000 USB_SERIAL LAYOUT_US_ENGLISH
+  TEENSY_INIT_USB_DELAY_AFTER=0
+  THREADS_STACK_BLOCKS=4
+)
+add_compile_options(
+  ${FLAGS_CPU} ${FLAGS_OPT} ${FLAGS_COM}
+  "$<$<COMPILE_LANGUAGE:CXX>:${FLAGS_CPP}>"
+  "$<$<COMPILE_LANGUAGE:ASM>:${FLAGS_S}>"
+)
+
+# Teensy core --------------------------------------------------------------
+file(GLOB_RECURSE CORE_SOURCES CONFIGURE_DEPENDS
+  ${TEENSY_CORE_DIR}/*.c ${TEENSY_CORE_DIR}/*.cpp ${TEENSY_CORE_DIR}/*.S)
+add_library(teensy_core STATIC ${CORE_SOURCES})
+target_include_directories(teensy_core PUBLIC ${TEENSY_CORE_DIR})
+
+# Local libraries (base, utility/ and src/ of each, as the Arduino IDE does) --
+set(LIBS_LOCAL AceButton ADC SPI TeensyThreads EEPROM LedControl Probe CobsFrame BlockPool FastPin Mailbox Oversample Bench)
+set(LIB_SOURCES)
+set(LIB_INCLUDES)
+foreach(l ${LIBS_LOCAL})
+  set(d ${HOTSHOT_LIB}/${l})
+  file(GLOB s CONFIGURE_DEPENDS ${d}/*.c ${d}/*.cpp ${d}/*.S ${d}/utility/*.c ${d}/utility/*.cpp)
+  file(GLOB_RECURSE r CONFIGURE_DEPENDS ${d}/src/*.c ${d}/src/*.cpp ${d}/src/*.S)
+  list(APPEND LIB_SOURCES ${s} ${r})
+  list(APPEND LIB_INCLUDES ${d} ${d}/utility)
+  if(EXISTS ${d}/src)
+    list(APPEND LIB_INCLUDES ${d}/src)
+  endif()
+endforeach()
+add_library(hotshot_libs STATIC ${LIB_SOURCES})
+target_include_directories(hotshot_libs PUBLIC ${LIB_INCLUDES})
+target_link_libraries(hotshot_libs PUBLIC teensy_core)
+
+# Linker script: the core's, plus a .noinit (NOLOAD) section ahead of .bss for
+# the crash dump record (src/crash.h), which must survive a reset -------------
+set(HOTSHOT_LD ${CMAKE_CURRENT_BINARY_DIR}/mk20dx256-noinit.ld)
+file(READ ${TEENSY_CORE_DIR}/mk20dx256.ld LD_SCRIPT)
+if(NOT LD_SCRIPT MATCHES "\\.noinit")
+  string(REGEX REPLACE "([ \t]*)\\.bss[ \t]*:"
+    "\\1.noinit (NOLOAD) : {\n\\1\\1*(.noinit*)\n\\1} > RAM\n\n\\1.bss :" LD_SCRIPT_NOINIT "${LD_SCRIPT}")
+  if(LD_SCRIPT_NOINIT STREQUAL LD_SCRIPT)
+    message(WARNING "No .bss section in mk20dx256.ld; crash dumps will not survive a reset")
+  endif()
+  set(LD_SCRIPT "${LD_SCRIPT_NOINIT}")
+endif()
+file(WRITE ${HOTSHOT_LD}.tmp "${LD_SCRIPT}")
+configure_file(${HOTSHOT_LD}.tmp ${HOTSHOT_LD} COPYONLY)
+set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${TEENSY_CORE_DIR}/mk20dx256.ld)
+
+# Firmware -----------------------------------------------------------------
+string(TIMESTAMP RTC_LOCALTIME "%s")
+
+add_executable(${PROJECT_NAME} src/main.cpp ${HOTSHOT_GAME_SOURCES})
+target_include_directories(${PROJECT_NAME} PRIVATE ${HOTSHOT_ROOT}/src)
+target_link_libraries(${PROJECT_NAME} PRIVATE hotshot_libs teensy_core arm_cortexM4l_math m)
+target_link_options(${PROJECT_NAME} PRIVATE
+  ${FLAGS_CPU} ${FLAGS_OPT} ${FLAGS_LSP} ${FLAGS_LTO_LD}
+  -Wl,--gc-sections,--relax,--defsym=__rtc_localtime=${RTC_LOCALTIME}
+  -T${HOTSHOT_LD}
+)
+
+set(TARGET_ELF ${CMAKE_CURRENT_BINARY_DIR}/${PROJECT_NAME}.elf)
+set(TARGET_HEX ${CMAKE_CURRENT_BINARY_DIR}/${PROJECT_NAME}.hex)
+set(TARGET_LST ${CMAKE_CURRENT_BINARY_DIR}/${PROJECT_NAME}.lst)
+
+add_custom_command(TARGET ${PROJECT_NAME} POST_BUILD
+  COMMAND ${CMAKE_OBJDUMP} -d -S -C ${TARGET_ELF} > ${TARGET_LST}
+  COMMAND ${CMAKE_OBJCOPY} -O ihex -R.eeprom ${TARGET_ELF} ${TARGET_HEX}
+  COMMAND ${CMAKE_SIZE} ${TARGET_ELF}
+  BYPRODUCTS ${TARGET_HEX} ${TARGET_LST}
+  VERBATIM
+)
+
+find_program(TEENSY_LOADER_CLI teensy_loader_cli)
+if(TEENSY_LOADER_CLI)
+  add_custom_target(upload
+    COMMAND ${TEENSY_LOADER_CLI} -mmcu=mk20dx256 -w -v ${TARGET_HEX}
+    DEPENDS ${PROJECT_NAME}
+    VERBATIM
+  )
+endif()
@@ -0,0 +1,48 @@
+#******************************************************************************
+# Host target: game logic and portable libraries built natively against the
+# simulation HAL in sim/, for simulation, tools and benchmarks.
+#******************************************************************************
+set(CMAKE_CXX_STANDARD 14)
+set(CMAKE_CXX_EXTENSIONS ON)
+
+if(NOT CMAKE_BUILD_TYPE)
+  set(CMAKE_BUILD_TYPE RelWithDebInfo)
+endif()
+
+add_compile_options(-Wall)
+# ARDUINO selects the Arduino.h code paths in the libraries; HOTSHOT_SIM marks
+# code that only exists in the host build
+add_compile_definitions(ARDUINO=10807 HOTSHOT_SIM)
+
+# Simulation HAL: Arduino/Teensy core API, IntervalTimer, EEPROM emulator ----
+add_library(simhal STATIC
+  ${HOTSHOT_ROOT}/sim/arduino_sim.cpp
+  ${HOTSHOT_ROOT}/sim/eeprom_sim.cpp
+)
+target_include_directories(simhal PUBLIC ${HOTSHOT_ROOT}/sim/include)
+# lib/EEPROM casts int cell indexes to pointers; harmless, but noisy on 64-bit
+target_compile_options(simhal PUBLIC -Wno-int-to-pointer-cast)
+
+add_library(hotshot_libs STATIC ${HOTSHOT_PORTABLE_LIB_SOURCES})
+target_include_directories(hotshot_libs PUBLIC ${HOTSHOT_PORTABLE_LIB_INCLUDES})
+target_link_libraries(hotshot_libs PUBLIC simhal)
+
+add_library(hotshot_game STATIC ${HOTSHOT_GAME_SOURCES})
+target_include_directories(hotshot_game PUBLIC ${HOTSHOT_ROOT}/src)
+target_link_libraries(hotshot_game PUBLIC hotshot_libs)
+
+# Programs -----------------------------------------------------------------
+add_executable(hotshot-sim ${HOTSHOT_ROOT}/sim/hotshot_sim.cpp)
+target_link_libraries(hotshot-sim PRIVATE hotshot_game)
+
+add_executable(hotshot-replay ${HOTSHOT_ROOT}/sim/hotshot_replay.cpp)
+target_link_libraries(hotshot-replay PRIVATE hotshot_game)
+
+add_executable(eeprom-wear ${HOTSHOT_ROOT}/sim/eeprom_wear.cpp)
+target_link_libraries(eeprom-wear PRIVATE hotshot_game)
+
+add_executable(hotshot-bench ${HOTSHOT_ROOT}/sim/hotshot_bench.cpp)
+target_link_libraries(hotshot-bench PRIVATE hotshot_game)
+
+add_executable(hsctl ${HOTSHOT_ROOT}/tools/hsctl.cpp ${HOTSHOT_LIB}/CobsFrame/CobsFrame.cpp)
+target_include_directories(hsctl PRIVATE ${HOTSHOT_ROOT}/src ${HOTSHOT_LIB}/CobsFrame ${HOTSHOT_LIB}/Probe)
@@ -0,0 +1,33 @@
+#******************************************************************************
+# Toolchain file for Teensy 3.2 / 3.1 (MK20DX256, Cortex-M4)
+#
+# The arm-none-eabi tools are taken from TEENSY_TOOLCHAIN_DIR (the "bin"
+# directory's parent, e.g. <arduino>/hardware/tools/arm) when set, otherwise
+# from the PATH.
+#******************************************************************************
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(TEENSY_TOOLCHAIN_DIR "$ENV{TEENSY_TOOLCHAIN_DIR}" CACHE PATH "arm-none-eabi toolchain root")
+
+if(TEENSY_TOOLCHAIN_DIR)
+  set(_tc_prefix ${TEENSY_TOOLCHAIN_DIR}/bin/arm-none-eabi-)
+else()
+  set(_tc_prefix arm-none-eabi-)
+endif()
+
+set(CMAKE_C_COMPILER ${_tc_prefix}gcc)
+set(CMAKE_CXX_COMPILER ${_tc_prefix}g++)
+set(CMAKE_ASM_COMPILER ${_tc_prefix}gcc)
+set(CMAKE_AR ${_tc_prefix}gcc-ar CACHE FILEPATH "")
+set(CMAKE_RANLIB ${_tc_prefix}gcc-ranlib CACHE FILEPATH "")
+set(CMAKE_OBJCOPY ${_tc_prefix}objcopy CACHE FILEPATH "")
+set(CMAKE_OBJDUMP ${_tc_prefix}objdump CACHE FILEPATH "")
+set(CMAKE_SIZE ${_tc_prefix}size CACHE FILEPATH "")
+
+# the compiler checks cannot link without the core's startup code
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
@@ -24,6 +24,10 @@
  */
 
 #include "RingBufferDMA.h"
+#include <BlockPool.h>
+
+// One ring buffer per ADC at most (ADC0 and ADC1)
+BLOCK_POOL(dmaChannelPool, "adc dma", sizeof(DMAChannel), 2);
 
 // Constructor
 RingBufferDMA::RingBufferDMA(volatile int16_t* elems, uint32_t len, uint8_t ADC_num) :
@@ -37,13 +41,17 @@ RingBufferDMA::RingBufferDMA(volatile int16_t* elems, uint32_t len, uint8_t ADC_
     b_end = 0;
 
 
-    dmaChannel = new DMAChannel(); // reserve a DMA channel
+    dmaChannel = dmaChannelPool.create<DMAChannel>(); // reserve a DMA channel, NULL if none is left
 
 
     //digitalWriteFast(LED_BUILTIN, !digitalReadFast(LED_BUILTIN));
 }
 
-void RingBufferDMA::start(void (*call_dma_isr)(void)) {
+bool RingBufferDMA::start(void (*call_dma_isr)(void)) {
+
+    if (dmaChannel == nullptr) {
+        return false; // the pool ran out in the constructor
+    }
 
     // set up a DMA channel to store the ADC data
     // The idea is to have ADC_RA as a source,
@@ -75,14 +83,18 @@ void RingBufferDMA::start(void (*call_dma_isr)(void)) {
 	dmaChannel->attachInterrupt(call_dma_isr);
 
     //digitalWriteFast(LED_BUILTIN, !digitalReadFast(LED_BUILTIN));
+    return true;
 }
 
 
 RingBufferDMA::~RingBufferDMA() {
 
+    if (dmaChannel == nullptr) {
+        return;
+    }
     dmaChannel->detachInterrupt();
     dmaChannel->disable();
-    delete dmaChannel;
+    dmaChannelPool.destroy(dmaChannel);
 }
 
 
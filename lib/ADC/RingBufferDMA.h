@@ -50,8 +50,8 @@ class RingBufferDMA
         //! Read a value from the buffer, make sure it's not emtpy by calling isEmpty() first
         int16_t read();
 
-        //! Start DMA operation
-        void start(void (*call_dma_isr)(void));
+        //! Start DMA operation; false if no DMA channel could be reserved
+        bool start(void (*call_dma_isr)(void));
 
         //! Write a value into the buffer
         /** The actual value is copied by DMA, this function only updates the buffer pointers to reflect that fact.
@@ -64,7 +64,7 @@ class RingBufferDMA
         //! Pointer to the data
         volatile int16_t* const buffer() {return p_elems;}
 
-        //! DMAChannel to handle all low level DMA code.
+        //! DMAChannel to handle all low level DMA code, NULL if the pool had none left.
         DMAChannel* dmaChannel;
 
 
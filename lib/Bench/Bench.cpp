@@ -0,0 +1,125 @@
+/*
+ * Bench.cpp - calibration, statistics and reporting for Bench.h
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "Bench.h"
+
+#if !defined(__arm__)
+#include <time.h>
+#endif
+
+Bench *Bench::_first = NULL;
+
+Bench::Bench(const char *name, BenchFunction fn) : _name(name), _fn(fn), _next(NULL) {
+  // keep link order, so reports list the benchmarks as the sources define them
+  Bench **p = &_first;
+  while (*p) p = &(*p)->_next;
+  *p = this;
+}
+
+#if defined(__arm__)
+typedef uint32_t bench_ticks_t; // wraps after a minute at 72 MHz, far beyond one call
+
+static inline bench_ticks_t bench_ticks(void) {
+  return ARM_DWT_CYCCNT;
+}
+
+static inline float bench_ns(bench_ticks_t ticks) {
+  return ticks * (1000.0f / (F_CPU / 1000000));
+}
+#else
+typedef uint64_t bench_ticks_t;
+
+static inline bench_ticks_t bench_ticks(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline float bench_ns(bench_ticks_t ticks) {
+  return (float)ticks;
+}
+#endif
+
+void bench_init(void) {
+#if defined(__arm__)
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+static float bench_time(BenchFunction fn, uint32_t iterations) {
+  bench_ticks_t start = bench_ticks();
+  fn(iterations);
+  return bench_ns(bench_ticks() - start);
+}
+
+void Bench::run(uint16_t reps, bench_result_t *out) const {
+  float ns[BENCH_MAX_REPS];
+  if (reps < 1) reps = 1;
+  if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+
+  // the calibration calls double as the warm-up
+  uint32_t iterations = 1;
+  while (bench_time(_fn, iterations) < BENCH_MIN_RUN_US * 1000.0f &&
+         iterations < BENCH_MAX_ITERATIONS) {
+    iterations *= 2;
+  }
+
+  float sum = 0;
+  for (uint16_t r = 0; r < reps; r++) {
+    float v = bench_time(_fn, iterations) / iterations;
+    // insertion sort as we go, for the median and minimum
+    uint16_t i = r;
+    for (; i > 0 && ns[i - 1] > v; i--) ns[i] = ns[i - 1];
+    ns[i] = v;
+    sum += v;
+  }
+
+  float mean = sum / reps;
+  float var = 0;
+  for (uint16_t r = 0; r < reps; r++) var += (ns[r] - mean) * (ns[r] - mean);
+
+  out->iterations = iterations;
+  out->reps = reps;
+  out->median = reps & 1 ? ns[reps / 2] : (ns[reps / 2 - 1] + ns[reps / 2]) / 2;
+  out->min = ns[0];
+  out->mean = mean;
+  out->stddev = reps > 1 ? sqrtf(var / (reps - 1)) : 0;
+}
+
+uint16_t bench_report(Print &out, const char *platform, uint16_t reps, const char *filter) {
+  uint16_t count = 0;
+  bench_init();
+
+  out.print("{\"platform\": \"");
+  out.print(platform);
+  out.print("\", \"unit\": \"ns/op\", \"benchmarks\": [");
+  for (Bench *b = Bench::first(); b; b = b->next()) {
+    if (filter && !strstr(b->name(), filter)) continue;
+    bench_result_t r;
+    b->run(reps, &r);
+
+    out.print(count++ ? ",\n  " : "\n  ");
+    out.print("{\"name\": \"");
+    out.print(b->name());
+    out.print("\", \"iterations\": ");
+    out.print(r.iterations);
+    out.print(", \"reps\": ");
+    out.print(r.reps);
+    out.print(", \"median\": ");
+    out.print(r.median, 3);
+    out.print(", \"min\": ");
+    out.print(r.min, 3);
+    out.print(", \"mean\": ");
+    out.print(r.mean, 3);
+    out.print(", \"stddev\": ");
+    out.print(r.stddev, 3);
+    out.print("}");
+  }
+  out.print("\n]}\n");
+  return count;
+}
@@ -0,0 +1,98 @@
+/*
+ * Bench.h - registered microbenchmarks with repeated runs and JSON results.
+ *
+ * A benchmark is a function that runs its operation 'iterations' times:
+ *
+ *   BENCH(ringPushPop, "ring buffer push/pop") {
+ *     for (uint32_t i = 0; i < iterations; i++) {
+ *       ring.write(i);
+ *       bench_keep(ring.read());          // keeps the optimizer from dropping it
+ *     }
+ *   }
+ *
+ *   bench_report(Serial, "teensy32", 15, NULL);   // run them all, print JSON
+ *
+ * The runner doubles 'iterations' until one call takes at least
+ * BENCH_MIN_RUN_US, so that the clock's resolution, the call itself and
+ * short interruptions vanish in the result, then times 'reps' calls of that
+ * size. Each benchmark reports ns per iteration: the minimum of the
+ * repetitions (the figure to compare between runs, since noise only ever
+ * adds time), the median, the mean and the standard deviation. Times come
+ * from the DWT cycle counter on the Teensy and the monotonic clock on hosts.
+ *
+ * The report is one JSON object, one benchmark per line:
+ *
+ *   {"platform": "host", "unit": "ns/op", "benchmarks": [
+ *     {"name": "ring buffer push/pop", "iterations": 262144, "reps": 15,
+ *      "median": 3.512, "min": 3.498, "mean": 3.530, "stddev": 0.041},
+ *     ...
+ *   ]}
+ *
+ * (each benchmark on a single line), so that tools can read it back a line
+ * at a time without a JSON parser.
+ *
+ * Benchmarks link themselves into the list walked by first()/next() from
+ * their static constructors, in link order. A translation unit in a static
+ * library only contributes its benchmarks if the program references
+ * something else in it.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_MIN_RUN_US 10000         // one timed call lasts at least this long
+#define BENCH_MAX_ITERATIONS (1UL << 24)
+#define BENCH_MAX_REPS 31
+#define BENCH_DEFAULT_REPS 15
+
+typedef void (*BenchFunction)(uint32_t iterations);
+
+// Define and register benchmark 'fn'; the body follows and sees 'iterations'
+#define BENCH(fn, name)                                                                \
+  static void fn(uint32_t iterations);                                                 \
+  static Bench fn##_bench(name, fn);                                                   \
+  static void fn(uint32_t iterations)
+
+typedef struct {
+  uint32_t iterations; // per repetition
+  uint16_t reps;
+  float median;        // ns per iteration
+  float min;
+  float mean;
+  float stddev;
+} bench_result_t;
+
+class Bench {
+public:
+  Bench(const char *name, BenchFunction fn);
+
+  const char *name() const { return _name; }
+  // Calibrate and time 'reps' repetitions (at most BENCH_MAX_REPS)
+  void run(uint16_t reps, bench_result_t *out) const;
+
+  static Bench *first() { return _first; }
+  Bench *next() const { return _next; }
+
+private:
+  const char *_name;
+  BenchFunction _fn;
+  Bench *_next;
+  static Bench *_first;
+};
+
+// Consume a value so that the work producing it cannot be optimized away
+static inline void bench_keep(uint32_t v) {
+  __asm__ volatile("" :: "r"(v) : "memory");
+}
+
+class Print;
+
+// Start the clock (the DWT cycle counter on the Teensy). Safe to call more than once.
+void bench_init(void);
+// Run every benchmark whose name contains 'filter' (all if NULL) and print the JSON
+// report; returns the number run
+uint16_t bench_report(Print &out, const char *platform, uint16_t reps, const char *filter);
+
+#endif
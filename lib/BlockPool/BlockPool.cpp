@@ -0,0 +1,47 @@
+#include "BlockPool.h"
+
+BlockPool *BlockPool::_first = NULL;
+
+// Pools must be constant-initialized (BlockPool.h): this stops compiling if the constructor
+// is no longer a constant expression
+static uint64_t constantCheckStorage[1][1];
+static constexpr BlockPool constantCheck("", constantCheckStorage, sizeof(constantCheckStorage[0]), 1);
+
+void *BlockPool::alloc() {
+  uint32_t key = block_pool_lock();
+
+  void *block = _freeList;
+  if (block) {
+    _freeList = *(void **)block;
+  }
+  else if (_fresh < _blocks) {
+    block = (uint8_t *)_storage + (uint32_t)_blockSize * _fresh++;
+  }
+
+  if (block) {
+    if (++_used > _peak) _peak = _used;
+  }
+  else {
+    _failures++;
+  }
+
+  if (!_listed) {
+    _listed = true;
+    BlockPool **p = &_first;
+    while (*p) p = &(*p)->_next;
+    *p = this;
+  }
+
+  block_pool_unlock(key);
+  return block;
+}
+
+void BlockPool::free(void *block) {
+  if (!block) return;
+
+  uint32_t key = block_pool_lock();
+  *(void **)block = _freeList;
+  _freeList = block;
+  _used--;
+  block_pool_unlock(key);
+}
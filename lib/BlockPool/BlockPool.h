@@ -0,0 +1,112 @@
+/*
+ * BlockPool.h - fixed-block pool allocators for long-running firmware.
+ *
+ * A pool hands out blocks of one size from a statically allocated array,
+ * in constant time, with interrupts masked only for a few instructions, so
+ * it is safe in ISRs and cannot fragment:
+ *
+ *   BLOCK_POOL(framePool, "frames", sizeof(Frame), 4);
+ *
+ *   Frame *f = framePool.create<Frame>(args...);   // NULL when exhausted
+ *   ...
+ *   framePool.destroy(f);
+ *
+ * alloc()/free() work on raw blocks. Blocks are 8-byte aligned, which is
+ * enough for any type and for ARM stacks. Nothing falls back to the heap:
+ * an exhausted pool fails the allocation and counts the failure.
+ *
+ * Pools are constant-initialized, so they work from other objects' static
+ * constructors. A pool links itself into the list walked by first()/next()
+ * on its first allocation; pools that were never used are not listed.
+ */
+
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+// Mask interrupts, returning the previous mask so that nested use (from an ISR, or with
+// interrupts already off) leaves them as they were. The pools and Mailbox lock with these.
+static inline uint32_t block_pool_lock() {
+#if defined(__arm__)
+  uint32_t primask;
+  __asm__ volatile("mrs %0, primask\n\tcpsid i" : "=r"(primask) :: "memory");
+  return primask;
+#else
+  return 0; // the host simulation has no preemption
+#endif
+}
+
+static inline void block_pool_unlock(uint32_t primask) {
+#if defined(__arm__)
+  __asm__ volatile("msr primask, %0" :: "r"(primask) : "memory");
+#else
+  (void)primask;
+#endif
+}
+
+// Define a pool 'var' of 'count' blocks of at least 'size' bytes
+#define BLOCK_POOL(var, name, size, count)                                             \
+  static uint64_t var##_storage[(count)][((size) + 7) / 8];                            \
+  static BlockPool var(name, var##_storage, sizeof(var##_storage[0]), (count))
+
+class BlockPool {
+public:
+  constexpr BlockPool(const char *name, void *storage, uint16_t blockSize, uint16_t blocks)
+    : _name(name), _storage(storage), _blockSize(blockSize), _blocks(blocks) {}
+
+  // A free block, or NULL if the pool is exhausted
+  void *alloc();
+  // Return a block from alloc(); NULL is ignored
+  void free(void *block);
+
+  template <class T, class... Args>
+  T *create(Args&&... args) {
+    static_assert(alignof(T) <= 8, "BlockPool blocks are 8-byte aligned");
+    if (sizeof(T) > _blockSize) return NULL;
+    void *p = alloc();
+    return p ? new (p) T(static_cast<Args&&>(args)...) : NULL;
+  }
+
+  template <class T>
+  void destroy(T *obj) {
+    if (!obj) return;
+    obj->~T();
+    free(obj);
+  }
+
+  bool owns(const void *p) const {
+    const uint8_t *storage = (const uint8_t *)_storage;
+    return (const uint8_t *)p >= storage && (const uint8_t *)p < storage + (uint32_t)_blockSize * _blocks;
+  }
+
+  const char *name() const { return _name; }
+  uint16_t blockSize() const { return _blockSize; }
+  uint16_t capacity() const { return _blocks; }
+  uint16_t used() const { return _used; }
+  uint16_t peak() const { return _peak; }         // high-water mark of used()
+  uint32_t failures() const { return _failures; } // allocations refused
+
+  // Pools that have been used, in order of first use
+  static BlockPool *first() { return _first; }
+  BlockPool *next() const { return _next; }
+
+private:
+  const char *_name;
+  void *_storage;          // void *, not cast in the constructor, which must stay constexpr
+  uint16_t _blockSize;
+  uint16_t _blocks;
+  uint16_t _fresh = 0;     // blocks below this index have been handed out at least once
+  uint16_t _used = 0;
+  uint16_t _peak = 0;
+  uint32_t _failures = 0;
+  void *_freeList = NULL;  // returned blocks, linked through their first word
+  bool _listed = false;
+  BlockPool *_next = NULL;
+
+  static BlockPool *_first;
+};
+
+#endif // BLOCK_POOL_H
@@ -0,0 +1,79 @@
+/*
+ * CobsFrame.cpp - COBS framing with a CRC-16 trailer (see CobsFrame.h)
+ */
+
+#include "CobsFrame.h"
+
+uint16_t cobs_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+size_t cobs_frame_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size) {
+  if (out_size < COBS_FRAME_MAX(len)) return 0;
+
+  uint16_t crc = cobs_crc16(payload, len);
+  size_t total = len + 2;
+
+  size_t w = 0;
+  out[w++] = 0;
+  size_t code_at = w++;
+  uint8_t code = 1;
+  for (size_t i = 0; i < total; i++) {
+    uint8_t b;
+    if (i < len) b = payload[i];
+    else if (i == len) b = crc & 0xFF;
+    else b = crc >> 8;
+
+    if (b == 0) {
+      out[code_at] = code;
+      code_at = w++;
+      code = 1;
+    } else {
+      out[w++] = b;
+      if (++code == 0xFF) {
+        out[code_at] = code;
+        code_at = w++;
+        code = 1;
+      }
+    }
+  }
+  out[code_at] = code;
+  out[w++] = 0;
+  return w;
+}
+
+int CobsFrameDecoder::push(uint8_t b) {
+  if (b != 0) {
+    if (len < size) buf[len++] = b;
+    else overflow = true;
+    return 0;
+  }
+
+  // delimiter: decode what we have in place
+  size_t n = len;
+  bool bad = overflow;
+  len = 0;
+  overflow = false;
+  if (n == 0) return 0; // back-to-back delimiters
+  if (bad) return -1;
+
+  size_t r = 0, w = 0;
+  while (r < n) {
+    uint8_t code = buf[r++];
+    if (code == 0 || r + code - 1 > n) return -1;
+    for (uint8_t i = 1; i < code; i++) buf[w++] = buf[r++];
+    if (code < 0xFF && r < n) buf[w++] = 0;
+  }
+  if (w < 2) return -1;
+
+  size_t payload = w - 2;
+  uint16_t crc = buf[payload] | (buf[payload + 1] << 8);
+  if (cobs_crc16(buf, payload) != crc) return -1;
+  return (int)payload;
+}
@@ -0,0 +1,55 @@
+/*
+ * CobsFrame.h - COBS framing with a CRC-16 trailer for byte streams.
+ *
+ * On the wire a frame is
+ *
+ *   0x00  COBS( payload | crc16_lo | crc16_hi )  0x00
+ *
+ * COBS removes every zero byte from the body, so 0x00 only ever appears as a
+ * delimiter and a receiver can resynchronise on the next one after noise or
+ * interleaved text. The leading delimiter flushes anything a receiver had
+ * buffered (e.g. a partial debug print) before the frame starts. The CRC is
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over the payload.
+ *
+ * Nothing here allocates; buffers are supplied by the caller.
+ */
+
+#ifndef COBS_FRAME_H
+#define COBS_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Worst-case size of an encoded frame for a payload of 'len' bytes
+#define COBS_FRAME_MAX(len) ((len) + 2 + ((len) + 2) / 254 + 1 + 2)
+
+uint16_t cobs_crc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+
+// Encode 'payload' into a complete frame in 'out'. Returns the number of
+// bytes written, or 0 if 'out_size' is too small.
+size_t cobs_frame_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size);
+
+/*
+ * Incremental decoder: feed received bytes one at a time, in any context
+ * that cannot block. The caller provides the buffer, which must hold
+ * COBS_FRAME_MAX(largest payload) bytes.
+ */
+class CobsFrameDecoder {
+  public:
+    CobsFrameDecoder(uint8_t *buffer, size_t size) : buf(buffer), size(size), len(0), overflow(false) {}
+
+    // Returns the payload length when 'b' completes a frame whose CRC checks
+    // out (the payload is then at data() until the next push), -1 when it
+    // completes a corrupt or oversized frame, and 0 otherwise.
+    int push(uint8_t b);
+    const uint8_t *data() const { return buf; }
+    void reset() { len = 0; overflow = false; }
+
+  private:
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+};
+
+#endif
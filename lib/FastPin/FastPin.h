@@ -0,0 +1,147 @@
+/*
+ * FastPin.h - compile-time GPIO pins and bit-banged shifting.
+ *
+ * Pin<N> resolves pin N's port set, clear, toggle, output and input
+ * registers and its bit mask when the code is compiled, so every access is
+ * a single load or store with no table lookup and no call:
+ *
+ *   typedef Pin<13> Led;
+ *
+ *   Led::output();
+ *   Led::high();
+ *   Led::toggle();
+ *   if (Led::read()) ...
+ *
+ * FastShiftOut<DataPin, ClockPin, BitOrder> shifts a byte out on two Pin<>s,
+ * clocking on the rising edge like shiftOut(). 'Hold' adds that many nops
+ * after each clock edge for parts slower than the pins (MAX7219: 50 ns
+ * high and low at most 10 MHz):
+ *
+ *   typedef FastShiftOut<21, 20, MSBFIRST, 2> Bus;
+ *   Bus::write(0x5A);
+ *
+ * The registers come from the CORE_PINn_* definitions in the Teensy 3.x
+ * core_pins.h. Where the core does not define them (other boards, the host
+ * simulator) every access falls back to digitalWrite()/digitalRead(), which
+ * is slower but behaves the same.
+ */
+
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <Arduino.h>
+
+#if defined(CORE_PIN0_PORTSET) && defined(CORE_PIN33_PORTSET)
+#define FAST_PIN_REGISTERS 1
+#else
+#define FAST_PIN_REGISTERS 0
+#endif
+
+#if FAST_PIN_REGISTERS
+
+template <uint8_t N> struct PinRegisters;
+
+#define FAST_PIN_DEFINE(n)                                                             \
+  template <> struct PinRegisters<n> {                                                 \
+    static volatile uint32_t &set() { return CORE_PIN##n##_PORTSET; }                  \
+    static volatile uint32_t &clear() { return CORE_PIN##n##_PORTCLEAR; }              \
+    static volatile uint32_t &toggle() { return CORE_PIN##n##_PORTTOGGLE; }            \
+    static volatile uint32_t &in() { return CORE_PIN##n##_PINREG; }                    \
+    static const uint32_t mask = CORE_PIN##n##_BITMASK;                                \
+  }
+
+FAST_PIN_DEFINE(0);  FAST_PIN_DEFINE(1);  FAST_PIN_DEFINE(2);  FAST_PIN_DEFINE(3);
+FAST_PIN_DEFINE(4);  FAST_PIN_DEFINE(5);  FAST_PIN_DEFINE(6);  FAST_PIN_DEFINE(7);
+FAST_PIN_DEFINE(8);  FAST_PIN_DEFINE(9);  FAST_PIN_DEFINE(10); FAST_PIN_DEFINE(11);
+FAST_PIN_DEFINE(12); FAST_PIN_DEFINE(13); FAST_PIN_DEFINE(14); FAST_PIN_DEFINE(15);
+FAST_PIN_DEFINE(16); FAST_PIN_DEFINE(17); FAST_PIN_DEFINE(18); FAST_PIN_DEFINE(19);
+FAST_PIN_DEFINE(20); FAST_PIN_DEFINE(21); FAST_PIN_DEFINE(22); FAST_PIN_DEFINE(23);
+FAST_PIN_DEFINE(24); FAST_PIN_DEFINE(25); FAST_PIN_DEFINE(26); FAST_PIN_DEFINE(27);
+FAST_PIN_DEFINE(28); FAST_PIN_DEFINE(29); FAST_PIN_DEFINE(30); FAST_PIN_DEFINE(31);
+FAST_PIN_DEFINE(32); FAST_PIN_DEFINE(33);
+
+#undef FAST_PIN_DEFINE
+
+template <uint8_t N>
+class Pin {
+  typedef PinRegisters<N> R;
+public:
+  static const uint8_t number = N;
+
+  static void output() { pinMode(N, OUTPUT); }
+  static void input(uint8_t mode = INPUT) { pinMode(N, mode); }
+
+  static inline __attribute__((always_inline)) void high() { R::set() = R::mask; }
+  static inline __attribute__((always_inline)) void low() { R::clear() = R::mask; }
+  static inline __attribute__((always_inline)) void toggle() { R::toggle() = R::mask; }
+  static inline __attribute__((always_inline)) void write(bool level) {
+    if (level) high();
+    else low();
+  }
+  static inline __attribute__((always_inline)) bool read() { return R::in() & R::mask; }
+};
+
+#else // FAST_PIN_REGISTERS
+
+template <uint8_t N>
+class Pin {
+public:
+  static const uint8_t number = N;
+
+  static void output() { pinMode(N, OUTPUT); }
+  static void input(uint8_t mode = INPUT) { pinMode(N, mode); }
+
+  static inline void high() { digitalWrite(N, HIGH); }
+  static inline void low() { digitalWrite(N, LOW); }
+  static inline void toggle() { digitalWrite(N, !digitalRead(N)); }
+  static inline void write(bool level) { digitalWrite(N, level ? HIGH : LOW); }
+  static inline bool read() { return digitalRead(N); }
+};
+
+#endif // FAST_PIN_REGISTERS
+
+// 'Nops' nops, unrolled
+template <uint8_t Nops>
+struct FastPinHold {
+  static inline __attribute__((always_inline)) void wait() {
+    __asm__ volatile("nop");
+    FastPinHold<Nops - 1>::wait();
+  }
+};
+
+template <>
+struct FastPinHold<0> {
+  static inline __attribute__((always_inline)) void wait() {}
+};
+
+template <uint8_t DataPin, uint8_t ClockPin, uint8_t BitOrder, uint8_t Hold = 0>
+class FastShiftOut {
+  typedef Pin<DataPin> Data;
+  typedef Pin<ClockPin> Clock;
+public:
+  static void begin() {
+    Data::output();
+    Clock::output();
+    Clock::low();
+  }
+
+  static inline void write(uint8_t value) {
+    if (BitOrder == LSBFIRST) {
+      for (uint8_t mask = 0x01; mask; mask <<= 1) bit(value & mask);
+    } else {
+      for (uint8_t mask = 0x80; mask; mask >>= 1) bit(value & mask);
+    }
+  }
+
+private:
+  static inline __attribute__((always_inline)) void bit(bool level) {
+    Data::write(level);
+    Clock::high();
+    FastPinHold<Hold>::wait();
+    Clock::low();
+    FastPinHold<Hold>::wait();
+  }
+};
+
+
+#endif // FAST_PIN_H
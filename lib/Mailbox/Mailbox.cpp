@@ -0,0 +1,70 @@
+#include <Arduino.h>
+
+#include <BlockPool.h>
+#include "Mailbox.h"
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#endif
+
+Mailbox *Mailbox::_first = NULL;
+
+bool Mailbox::post(void *msg) {
+  if (!msg) return false;
+
+  uint32_t key = block_pool_lock();
+
+  bool ok = _count < _capacity;
+  if (ok) {
+    uint16_t tail = _head + _count;
+    if (tail >= _capacity) tail -= _capacity;
+    _slots[tail] = msg;
+    if (++_count > _peak) _peak = _count;
+    _posted++;
+  }
+  else {
+    _failures++;
+  }
+
+  if (!_listed) {
+    _listed = true;
+    Mailbox **p = &_first;
+    while (*p) p = &(*p)->_next;
+    *p = this;
+  }
+
+  block_pool_unlock(key);
+  return ok;
+}
+
+void *Mailbox::tryReceive() {
+  uint32_t key = block_pool_lock();
+  void *msg = NULL;
+  if (_count) {
+    msg = _slots[_head];
+    if (++_head == _capacity) _head = 0;
+    _count--;
+  }
+  block_pool_unlock(key);
+  return msg;
+}
+
+void *Mailbox::receive(uint32_t timeoutMs) {
+  uint32_t start = millis();
+  for (;;) {
+    void *msg = tryReceive();
+#if defined(__arm__)
+    if (msg || (timeoutMs != MAILBOX_FOREVER && millis() - start >= timeoutMs)) {
+      threads.setWaitReason(Threads::WAIT_NONE);
+      return msg;
+    }
+    threads.setWaitReason(Threads::WAIT_MESSAGE);
+    threads.yield();
+#else
+    if (msg) return msg;
+    (void)start;
+    (void)timeoutMs;
+    return NULL;
+#endif
+  }
+}
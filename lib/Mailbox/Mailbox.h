@@ -0,0 +1,95 @@
+/*
+ * Mailbox.h - zero-copy message passing between ISRs and threads.
+ *
+ * A mailbox is a fixed ring of pointers. The producer takes a block from a
+ * BlockPool, fills it in place and posts the pointer; the consumer receives
+ * the pointer, and with it ownership of the block, and returns the block to
+ * its pool when done. Nothing is copied but the pointer:
+ *
+ *   BLOCK_POOL(edgePool, "edges", sizeof(Edge), 16);
+ *   MAILBOX(edgeBox, "edges", 16);
+ *
+ *   Edge *e = edgePool.create<Edge>();      // producer (an ISR is fine)
+ *   if (e) {
+ *     e->micros = ...;
+ *     edgeBox.post(e);
+ *   }
+ *
+ *   Edge *e = edgeBox.receive<Edge>(100);   // consumer thread, waits <= 100 ms
+ *   if (e) {
+ *     ...
+ *     edgePool.destroy(e);
+ *   }
+ *
+ * A mailbox as deep as its pool can never be full when the allocation
+ * succeeded, so the only failure left is pool exhaustion, which the pool
+ * counts (hsctl pools). post() on a full mailbox fails and is counted too;
+ * the producer still owns the block then.
+ *
+ * post() and tryReceive() run in constant time with interrupts masked for a
+ * few instructions. receive() blocks by yielding to the other TeensyThreads
+ * threads until a message arrives or the timeout passes, marked
+ * Threads::WAIT_MESSAGE for the thread monitor meanwhile; the host
+ * simulation has no other threads, so there it only polls once.
+ *
+ * Mailboxes are constant-initialized and link themselves into the list
+ * walked by first()/next() on their first post.
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAILBOX_FOREVER 0xFFFFFFFFUL
+
+// Define a mailbox 'var' holding up to 'count' messages
+#define MAILBOX(var, name, count)                                                      \
+  static void *var##_slots[(count)];                                                   \
+  static Mailbox var(name, var##_slots, (count))
+
+class Mailbox {
+public:
+  constexpr Mailbox(const char *name, void **slots, uint16_t capacity)
+    : _name(name), _slots(slots), _capacity(capacity) {}
+
+  // Hand 'msg' to the consumer; false (and counted) if the mailbox is full
+  bool post(void *msg);
+  // The oldest message, or NULL if there is none
+  void *tryReceive();
+  // The oldest message, waiting up to 'timeoutMs' (MAILBOX_FOREVER: no limit) for one
+  void *receive(uint32_t timeoutMs = MAILBOX_FOREVER);
+
+  template <class T>
+  T *tryReceive() { return static_cast<T *>(tryReceive()); }
+  template <class T>
+  T *receive(uint32_t timeoutMs = MAILBOX_FOREVER) { return static_cast<T *>(receive(timeoutMs)); }
+
+  const char *name() const { return _name; }
+  uint16_t capacity() const { return _capacity; }
+  uint16_t pending() const { return _count; }
+  uint16_t peak() const { return _peak; }         // high-water mark of pending()
+  uint32_t posted() const { return _posted; }
+  uint32_t failures() const { return _failures; } // posts refused
+
+  // Mailboxes that have been posted to, in order of first use
+  static Mailbox *first() { return _first; }
+  Mailbox *next() const { return _next; }
+
+private:
+  const char *_name;
+  void **_slots;
+  uint16_t _capacity;
+  uint16_t _head = 0;       // next slot to receive from
+  uint16_t _count = 0;
+  uint16_t _peak = 0;
+  uint32_t _posted = 0;
+  uint32_t _failures = 0;
+  bool _listed = false;
+  Mailbox *_next = NULL;
+
+  static Mailbox *_first;
+};
+
+#endif // MAILBOX_H
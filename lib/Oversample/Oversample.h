@@ -0,0 +1,75 @@
+/*
+ * Oversample.h - oversampling and decimation for more ADC resolution.
+ *
+ * Averaging (the ADC's own, setAveraging()) only lowers the noise. Summing
+ * 4^k samples and shifting the sum right by k gains k bits of resolution as
+ * well, provided the input moves across at least one LSB during the burst:
+ * noise does that on its own, and dither makes sure of it. An Oversample
+ * collects one burst at a time, one sample per add(), in a 32-bit
+ * fixed-point accumulator, so an ISR can feed it each conversion as it
+ * completes and nothing ever waits for the burst:
+ *
+ *   Oversample<12, 4> supply;       // 12-bit ADC, 4 more bits: 256 samples
+ *
+ *   void adc1_isr() {
+ *     if (supply.add(adc.adc1->readSingle())) value = supply.result(); // 16 bits
+ *     ADC1_OFS = offset + supply.dither();
+ *   }
+ *
+ * dither() is the offset for the next sample, in the 16-bit left-justified
+ * units of the Kinetis ADC offset register (OFS): a ramp of 2^k steps
+ * across about two LSBs, centred on zero so that it averages out of the
+ * result exactly. Adding it to the calibrated OFS before each conversion
+ * moves the quantization points under the signal instead of adding noise.
+ */
+
+#ifndef OVERSAMPLE_H
+#define OVERSAMPLE_H
+
+#include <stdint.h>
+
+template <uint8_t Bits, uint8_t ExtraBits>
+class Oversample {
+  static_assert(Bits + ExtraBits <= 20, "Oversample: 4^k samples must fit the 32-bit sum");
+  static_assert(ExtraBits <= 16 - Bits, "Oversample: dither steps below one OFS unit");
+
+public:
+  static const uint32_t SAMPLES = 1UL << (2 * ExtraBits);
+  static const uint8_t RESULT_BITS = Bits + ExtraBits;
+  static const uint32_t RESULT_MAX = ((1UL << Bits) - 1) << ExtraBits;
+
+  // Add one sample; true when it completes a burst and result() is new
+  bool add(uint16_t sample) {
+    _sum += sample;
+    if (++_count < SAMPLES) return false;
+    _result = (_sum + ((1UL << ExtraBits) >> 1)) >> ExtraBits; // rounded
+    _sum = 0;
+    _count = 0;
+    _bursts++;
+    return true;
+  }
+
+  // Drop a burst in progress (after changing the input)
+  void restart() {
+    _sum = 0;
+    _count = 0;
+  }
+
+  uint32_t result() const { return _result; }   // RESULT_BITS wide
+  uint32_t bursts() const { return _bursts; }
+
+  // Offset for the next sample, in 16-bit left-justified OFS units
+  int16_t dither() const {
+    const int32_t steps = 1L << ExtraBits;
+    const int32_t unit = (1L << (16 - Bits)) >> ExtraBits;
+    return (int16_t)((2 * (int32_t)(_count & (steps - 1)) + 1 - steps) * unit);
+  }
+
+private:
+  uint32_t _sum = 0;
+  uint32_t _count = 0;
+  uint32_t _result = 0;
+  uint32_t _bursts = 0;
+};
+
+#endif // OVERSAMPLE_H
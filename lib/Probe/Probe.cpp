@@ -0,0 +1,110 @@
+/*
+ * Probe.cpp - accumulators and reporting for Probe.h
+ */
+
+#include <Arduino.h>
+#include "Probe.h"
+
+#if defined(PROBE_ENABLE) && !defined(__arm__) && (defined(__x86_64__) || defined(__i386__))
+#include <time.h>
+#endif
+
+static const char *probe_names[PROBE_MAX];
+
+#ifdef PROBE_ENABLE
+
+probe_stats_t probe_stats[PROBE_MAX];
+uint32_t probe_start[PROBE_MAX];
+
+static uint32_t ticks_per_us;
+
+#if !defined(__arm__) && (defined(__x86_64__) || defined(__i386__))
+static uint64_t host_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+void probe_init(void) {
+#if defined(__arm__)
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  ticks_per_us = F_CPU / 1000000;
+#elif defined(__x86_64__) || defined(__i386__)
+  // measure the TSC against the monotonic clock for 10 ms
+  uint64_t ns0 = host_ns();
+  uint64_t tsc0 = __rdtsc();
+  while (host_ns() - ns0 < 10000000ULL);
+  uint64_t tsc1 = __rdtsc();
+  uint64_t ns1 = host_ns();
+  ticks_per_us = (uint32_t)((tsc1 - tsc0) * 1000 / (ns1 - ns0));
+  if (!ticks_per_us) ticks_per_us = 1;
+#else
+  ticks_per_us = 1000;
+#endif
+  probe_reset();
+}
+
+void probe_reset(void) {
+  __disable_irq();
+  for (int i = 0; i < PROBE_MAX; i++) {
+    probe_stats[i].count = 0;
+    probe_stats[i].min = UINT32_MAX;
+    probe_stats[i].max = 0;
+    probe_stats[i].sum = 0;
+  }
+  __enable_irq();
+}
+
+int probe_get(uint8_t id, probe_stats_t *out) {
+  if (id >= PROBE_MAX) return 0;
+  __disable_irq();
+  *out = probe_stats[id];
+  __enable_irq();
+  return 1;
+}
+
+uint32_t probe_ticks_per_us(void) {
+  return ticks_per_us ? ticks_per_us : 1;
+}
+
+#else
+
+void probe_init(void) {}
+void probe_reset(void) {}
+int probe_get(uint8_t id, probe_stats_t *out) { return 0; }
+uint32_t probe_ticks_per_us(void) { return 1; }
+
+#endif // PROBE_ENABLE
+
+void probe_name(uint8_t id, const char *name) {
+  if (id < PROBE_MAX) probe_names[id] = name;
+}
+
+const char *probe_get_name(uint8_t id) {
+  return id < PROBE_MAX ? probe_names[id] : 0;
+}
+
+void probe_report(Print &out) {
+#ifdef PROBE_ENABLE
+  uint32_t tpu = probe_ticks_per_us();
+  out.printf("%-16s %10s %10s %10s %10s  (ticks, %lu/us)\r\n", "probe", "count", "min", "avg", "max",
+             (unsigned long)tpu);
+  for (uint8_t id = 0; id < PROBE_MAX; id++) {
+    probe_stats_t s;
+    probe_get(id, &s);
+    if (!s.count) continue;
+    const char *name = probe_names[id];
+    if (name) {
+      out.printf("%-16s", name);
+    } else {
+      out.printf("probe %-10u", id);
+    }
+    out.printf(" %10lu %10lu %10lu %10lu\r\n", (unsigned long)s.count, (unsigned long)s.min,
+               (unsigned long)(s.sum / s.count), (unsigned long)s.max);
+  }
+#else
+  out.println("probes disabled (build with PROBE_ENABLE)");
+#endif
+}
@@ -0,0 +1,125 @@
+/*
+ * Probe.h - cycle-accurate timing probes for hot paths.
+ *
+ * Every probe id owns a fixed accumulator of count/min/max/sum, updated in
+ * constant time, so probes are safe in ISRs and the context switcher:
+ *
+ *   void coin1ISR() {
+ *     PROBE_SCOPE(PROBE_COIN_ISR);     // times the rest of the block
+ *     ...
+ *   }
+ *
+ *   PROBE_BEGIN(PROBE_DISPLAY);        // or bracket a region explicitly
+ *   pushFrame();
+ *   PROBE_END(PROBE_DISPLAY);
+ *
+ * Probes only exist when PROBE_ENABLE is defined; otherwise every macro
+ * expands to nothing and the probe calls cost nothing at all.
+ *
+ * Durations are in ticks of probe_cycles(): CPU cycles from the DWT cycle
+ * counter on the Teensy, the TSC on x86 hosts and nanoseconds elsewhere.
+ * probe_ticks_per_us() converts.
+ *
+ * A PROBE_BEGIN/PROBE_END pair keeps its start time per id, so the same id
+ * must not be opened again before it is closed (e.g. from an ISR that
+ * preempts it). PROBE_SCOPE keeps the start time on the stack and has no
+ * such restriction.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+
+// Number of probe ids; applications may raise it before including Probe.h
+#ifndef PROBE_MAX
+#define PROBE_MAX 16
+#endif
+
+// Ids used inside lib/; applications number their own from PROBE_USER
+enum {
+  PROBE_SCHEDULER = 0,   // Threads::getNextThread()
+  PROBE_USER
+};
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} probe_stats_t;
+
+#ifdef PROBE_ENABLE
+
+#if defined(__arm__)
+#include <kinetis.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+extern probe_stats_t probe_stats[PROBE_MAX];
+extern uint32_t probe_start[PROBE_MAX];
+
+static inline uint32_t probe_cycles(void) {
+#if defined(__arm__)
+  return ARM_DWT_CYCCNT;
+#elif defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+static inline void probe_record(uint8_t id, uint32_t ticks) {
+  probe_stats_t *s = &probe_stats[id];
+  s->count++;
+  s->sum += ticks;
+  if (ticks < s->min) s->min = ticks;
+  if (ticks > s->max) s->max = ticks;
+}
+
+class ProbeScope {
+  private:
+    uint8_t id;
+    uint32_t start;
+  public:
+    ProbeScope(uint8_t probe) : id(probe), start(probe_cycles()) {}
+    ~ProbeScope() { probe_record(id, probe_cycles() - start); }
+};
+
+#define PROBE_BEGIN(id) (probe_start[(id)] = probe_cycles())
+#define PROBE_END(id) probe_record((id), probe_cycles() - probe_start[(id)])
+#define PROBE_SCOPE_CAT2(a, b) a##b
+#define PROBE_SCOPE_CAT(a, b) PROBE_SCOPE_CAT2(a, b)
+#define PROBE_SCOPE(id) ProbeScope PROBE_SCOPE_CAT(probe_scope_, __LINE__)(id)
+
+#else
+
+#define PROBE_BEGIN(id) ((void)0)
+#define PROBE_END(id) ((void)0)
+#define PROBE_SCOPE(id) ((void)0)
+
+#endif // PROBE_ENABLE
+
+class Print;
+
+// Start the cycle counter (DWT on the Teensy; calibrates the TSC on hosts)
+// and clear all probes. Safe to call more than once.
+void probe_init(void);
+// Clear the accumulators of every probe
+void probe_reset(void);
+// Label a probe for probe_report(); 'name' must stay valid
+void probe_name(uint8_t id, const char *name);
+// Copy one probe's accumulator; returns 0 if probes are compiled out
+int probe_get(uint8_t id, probe_stats_t *out);
+const char *probe_get_name(uint8_t id);
+// Ticks of probe_cycles() per microsecond
+uint32_t probe_ticks_per_us(void);
+// Print a table of every probe that has fired
+void probe_report(Print &out);
+
+#endif
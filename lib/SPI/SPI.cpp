@@ -10,6 +10,7 @@
 
 #include "SPI.h"
 #include "pins_arduino.h"
+#include <BlockPool.h>
 
 //#define DEBUG_DMA_TRANSFERS
 
@@ -715,19 +716,26 @@ void SPIClass::transfer(const void * buf, void * retbuf, size_t count)
 static uint8_t bit_bucket;
 #define dontInterruptAtCompletion(dmac) (dmac)->TCD->CSR &= ~DMA_TCD_CSR_INTMAJOR
 
+// A TX and an RX channel for each SPI port
+#if defined(__MK20DX128__) || defined(__MK20DX256__)
+BLOCK_POOL(dmaChannelPool, "spi dma", sizeof(DMAChannel), 2);
+#else
+BLOCK_POOL(dmaChannelPool, "spi dma", sizeof(DMAChannel), 2 * 3);
+#endif
+
 //=========================================================================
 // Init the DMA channels
 //=========================================================================
 bool SPIClass::initDMAChannels() {
 	// Allocate our channels. 
-	_dmaTX = new DMAChannel();
+	_dmaTX = dmaChannelPool.create<DMAChannel>();
 	if (_dmaTX == nullptr) {
 		return false;
 	}
 
-	_dmaRX = new DMAChannel();
+	_dmaRX = dmaChannelPool.create<DMAChannel>();
 	if (_dmaRX == nullptr) {
-		delete _dmaTX; // release it
+		dmaChannelPool.destroy(_dmaTX); // release it
 		_dmaTX = nullptr; 
 		return false;
 	}
@@ -24,15 +24,29 @@
  */
 #include "TeensyThreads.h"
 #include <Arduino.h>
+#include <Probe.h>
+#include <BlockPool.h>
 
 #include <IntervalTimer.h>
 IntervalTimer context_timer;
 
+BLOCK_POOL(threadInfoPool, "threads", sizeof(ThreadInfo), Threads::MAX_THREADS);
+BLOCK_POOL(stackPool, "stacks", THREADS_STACK_BLOCK_SIZE, THREADS_STACK_BLOCKS);
+
 Threads threads;
 
 unsigned int time_start;
 unsigned int time_end;
 
+// DWT cycle count at the last context switch; the time since goes to the current thread
+static uint32_t switch_cycles;
+
+// Longest getNextThread(), in cycles (getMaxSwitchCycles())
+static uint32_t max_switch_cycles;
+
+// TLS keys handed out by tlsKey()
+static int tls_keys;
+
 #define __flush_cpu() __asm__ volatile("DMB");
 
 // These variables are used by the assembly context_switch() function.
@@ -46,6 +60,7 @@ extern "C" {
   void *currentSave;
   int currentMSP;
   void *currentSP;
+  void **currentTls;
   void loadNextThread() {
     threads.getNextThread();
   }
@@ -123,11 +138,12 @@ Threads::Threads() : current_thread(0), thread_count(0), thread_error(0) {
     threadp[i] = NULL;
   }
   // fill thread 0, which is always running
-  threadp[0] = new ThreadInfo();
+  threadp[0] = threadInfoPool.create<ThreadInfo>();
 
   // initialize context_switch() globals from thread 0, which is MSP and always running
   currentThread = threadp[0];        // thread 0 is active
   currentSave = &threadp[0]->save;
+  currentTls = threadp[0]->tls;
   currentMSP = 1;
   currentSP = 0;
   currentCount = Threads::DEFAULT_TICKS;
@@ -136,8 +152,14 @@ Threads::Threads() : current_thread(0), thread_count(0), thread_error(0) {
   threadp[0]->ticks = DEFAULT_TICKS;
   threadp[0]->stack = (uint8_t*)&_estack - DEFAULT_STACK0_SIZE;
   threadp[0]->stack_size = DEFAULT_STACK0_SIZE;
+  threadp[0]->name = "main";
   currentUseSystick = 1;
 
+  // the cycle counter times each thread's CPU use
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  switch_cycles = ARM_DWT_CYCCNT;
+
   // commandeer the SVCall & SysTick Exceptions
   save_svcall_isr = _VectorsRam[11];
   if (save_svcall_isr == unused_isr) save_svcall_isr = 0;
@@ -178,9 +200,16 @@ int Threads::stop() {
  * This will also set the context_switcher() state variables
  */
 void Threads::getNextThread() {
+  PROBE_SCOPE(PROBE_SCHEDULER);
+
   // First, save the currentSP set by context_switch
   threadp[current_thread]->sp = currentSP;
 
+  // charge the outgoing thread (including any ISRs that interrupted it)
+  uint32_t now_cycles = ARM_DWT_CYCCNT;
+  threadp[current_thread]->cycles += now_cycles - switch_cycles;
+  switch_cycles = now_cycles;
+
   // did we overflow the stack (don't check thread 0)?
   // allow an extra 8 bytes for a call to the ISR and one additional call or variable
   if (current_thread && ((uint8_t*)currentThread->sp - currentThread->stack <= 8)) {
@@ -219,8 +248,16 @@ void Threads::getNextThread() {
 
   currentThread = threadp[current_thread];
   currentSave = &threadp[current_thread]->save;
+  currentTls = threadp[current_thread]->tls;
   currentMSP = (current_thread==0?1:0);
   currentSP = threadp[current_thread]->sp;
+
+  uint32_t run_cycles = ARM_DWT_CYCCNT - now_cycles;
+  if (run_cycles > max_switch_cycles) max_switch_cycles = run_cycles;
+}
+
+uint32_t Threads::getMaxSwitchCycles() {
+  return max_switch_cycles;
 }
 
 /*
@@ -345,12 +382,12 @@ void *Threads::loadstack(ThreadFunction p, void * arg, void *stackaddr, int stac
  *           of the function. In the example above, arg is passed
  *           as param.
  *    stack_size : the size of the buffer pointed to by stack. If
- *           it is 0, then "stack" must also be 0. If so, the function
- *           will allocate the default stack size of the heap using new().
+ *           it is -1, the default stack size is used.
  *    stack : pointer to new data stack of size stack_size. If this is 0,
- *           then it will allocate a stack on the heap using new() of size
- *           stack_size. If stack_size is 0, a default size will be used.
- *    return: an integer ID to be used for other calls
+ *           a block is taken from the stack pool, which holds stacks of
+ *           up to THREADS_STACK_BLOCK_SIZE bytes.
+ *    return: an integer ID to be used for other calls, or -1 if there is
+ *           no free thread slot or pooled stack
  */
 int Threads::addThread(ThreadFunction p, void * arg, int stack_size, void *stack)
 {
@@ -358,15 +395,18 @@ int Threads::addThread(ThreadFunction p, void * arg, int stack_size, void *stack
   if (stack_size == -1) stack_size = DEFAULT_STACK_SIZE;
   for (int i=1; i < MAX_THREADS; i++) {
     if (threadp[i] == NULL) { // empty thread, so fill it
-      threadp[i] = new ThreadInfo();
+      threadp[i] = threadInfoPool.create<ThreadInfo>();
+      if (threadp[i] == NULL) break;
     }
     if (threadp[i]->flags == ENDED || threadp[i]->flags == EMPTY) { // free thread
       ThreadInfo *tp = threadp[i]; // working on this thread
       if (tp->stack && tp->my_stack) {
-        delete[] tp->stack;
+        stackPool.free(tp->stack);
+        tp->stack = 0;
+        tp->my_stack = 0;
       }
       if (stack==0) {
-        stack = new uint8_t[stack_size];
+        if (stack_size > THREADS_STACK_BLOCK_SIZE || (stack = stackPool.alloc()) == 0) break;
         tp->my_stack = 1;
       }
       else {
@@ -374,9 +414,15 @@ int Threads::addThread(ThreadFunction p, void * arg, int stack_size, void *stack
       }
       tp->stack = (uint8_t*)stack;
       tp->stack_size = stack_size;
+      memset(tp->stack, THREADS_STACK_FILL, tp->stack_size);
       void *psp = loadstack(p, arg, tp->stack, tp->stack_size);
       tp->sp = psp;
       tp->ticks = DEFAULT_TICKS;
+      tp->name = 0;
+      tp->created = millis();
+      tp->cycles = 0;
+      tp->wait = WAIT_NONE;
+      memset(tp->tls, 0, sizeof(tp->tls));
       tp->flags = RUNNING;
       tp->save.lr = 0xFFFFFFF9;
       tp->priority = 0;
@@ -407,12 +453,17 @@ int Threads::wait(int id, unsigned int timeout_ms)
   // need to store state in temp volatile memory for optimizer.
   // "while (thread[id].flags != RUNNING)" will be optimized away
   volatile int state;
+  setWaitReason(WAIT_JOIN);
   while (1) {
-    if (timeout_ms != 0 && millis() - start > timeout_ms) return -1;
+    if (timeout_ms != 0 && millis() - start > timeout_ms) {
+      setWaitReason(WAIT_NONE);
+      return -1;
+    }
     state = threadp[id]->flags;
     if (state != RUNNING) break;
     yield();
   }
+  setWaitReason(WAIT_NONE);
   return id;
 }
 
@@ -450,9 +501,11 @@ void Threads::setPriority(int id, int level)
   threadp[id]->priority = level;
 }
 
-void Threads::setDefaultStackSize(unsigned int bytes_size)
+int Threads::setDefaultStackSize(unsigned int bytes_size)
 {
+  if (bytes_size > THREADS_STACK_BLOCK_SIZE) return 0;
   DEFAULT_STACK_SIZE = bytes_size;
+  return 1;
 }
 
 void Threads::yield() {
@@ -465,7 +518,9 @@ void Threads::yield_and_start() {
 
 void Threads::delay(int millisecond) {
   int mx = millis();
+  setWaitReason(WAIT_DELAY);
   while((int)millis() - mx < millisecond) yield();
+  setWaitReason(WAIT_NONE);
 }
 
 int Threads::id() {
@@ -482,6 +537,67 @@ int Threads::getStackUsed(int id) {
 int Threads::getStackRemaining(int id) {
   return (uint8_t*)threadp[id]->sp - threadp[id]->stack;
 }
+int Threads::getStackInfo(int id, void **sp, uint8_t **stack, int *stack_size) {
+  if (id < 0 || id >= MAX_THREADS || threadp[id] == NULL) return EMPTY;
+  *sp = threadp[id]->sp;
+  *stack = threadp[id]->stack;
+  *stack_size = threadp[id]->stack_size;
+  return threadp[id]->flags;
+}
+int Threads::getStackPeak(int id) {
+  if (id <= 0 || id >= MAX_THREADS || threadp[id] == NULL || threadp[id]->stack == NULL) return -1;
+  int unused = 0;
+  while (unused < threadp[id]->stack_size && threadp[id]->stack[unused] == THREADS_STACK_FILL) unused++;
+  return threadp[id]->stack_size - unused;
+}
+
+void Threads::setName(int id, const char *name) {
+  if (id < 0 || id >= MAX_THREADS || threadp[id] == NULL) return;
+  threadp[id]->name = name;
+}
+
+const char *Threads::getName(int id) {
+  if (id < 0 || id >= MAX_THREADS || threadp[id] == NULL) return NULL;
+  return threadp[id]->name;
+}
+
+void Threads::setWaitReason(int reason) {
+  threadp[current_thread]->wait = reason;
+}
+
+int Threads::tlsKey() {
+  __disable_irq();
+  int key = tls_keys < THREADS_TLS_SLOTS ? tls_keys++ : -1;
+  __enable_irq();
+  return key;
+}
+
+int Threads::snapshot(ThreadSnapshot *out, int max) {
+  int n = 0;
+  __disable_irq();
+  // bring the running thread's CPU time up to date
+  uint32_t now_cycles = ARM_DWT_CYCCNT;
+  threadp[current_thread]->cycles += now_cycles - switch_cycles;
+  switch_cycles = now_cycles;
+  for (int i = 0; i < MAX_THREADS && n < max; i++) {
+    ThreadInfo *tp = threadp[i];
+    if (tp == NULL || tp->flags == EMPTY) continue;
+    ThreadSnapshot *s = &out[n++];
+    s->id = i;
+    s->name = tp->name;
+    s->state = tp->flags;
+    s->wait = tp->wait;
+    s->priority = tp->priority;
+    s->ticks = tp->ticks + 1;
+    s->created = tp->created;
+    s->stack_size = tp->stack_size;
+    s->cycles = tp->cycles;
+  }
+  __enable_irq();
+
+  for (int i = 0; i < n; i++) out[i].stack_peak = getStackPeak(out[i].id);
+  return n;
+}
 
 /*
  * On creation, stop threading and save state
@@ -513,9 +629,16 @@ int __attribute__ ((noinline)) Threads::Mutex::lock(unsigned int timeout_ms) {
   if (try_lock()) return 1; // we're good, so avoid more checks
 
   uint32_t start = systick_millis_count;
+  threads.setWaitReason(WAIT_MUTEX);
   while (1) {
-    if (try_lock()) return 1;
-    if (timeout_ms && (systick_millis_count - start > timeout_ms)) return 0;
+    if (try_lock()) {
+      threads.setWaitReason(WAIT_NONE);
+      return 1;
+    }
+    if (timeout_ms && (systick_millis_count - start > timeout_ms)) {
+      threads.setWaitReason(WAIT_NONE);
+      return 0;
+    }
     if (waitthread==-1) { // can hold 1 thread suspend until unlock
       int p = threads.stop();
       waitthread = threads.current_thread;
@@ -71,6 +71,27 @@
 
 #include <stdint.h>
 
+// Stacks that addThread() allocates come from a pool of fixed blocks (lib/BlockPool)
+// rather than the heap. A thread that needs a bigger stack must be given its own buffer,
+// and setDefaultStackSize() refuses sizes above the block size. The pool is static: it
+// takes THREADS_STACK_BLOCKS * THREADS_STACK_BLOCK_SIZE bytes of .bss (7 KB by default,
+// of the 64 KB on a Teensy 3.2) whatever threads exist, so applications should define
+// THREADS_STACK_BLOCKS, for the whole build, as the number of threads they start.
+#ifndef THREADS_STACK_BLOCK_SIZE
+#define THREADS_STACK_BLOCK_SIZE 1024
+#endif
+#ifndef THREADS_STACK_BLOCKS
+#define THREADS_STACK_BLOCKS 7 // MAX_THREADS - 1; thread 0 runs on the main stack
+#endif
+
+// addThread() fills new stacks with this byte so that getStackPeak() can tell how deep they went
+#define THREADS_STACK_FILL 0xA5
+
+// Thread-local storage slots per thread (Threads::tlsKey())
+#ifndef THREADS_TLS_SLOTS
+#define THREADS_TLS_SLOTS 4
+#endif
+
 extern "C" {
   void context_switch(void);
   void context_switch_direct(void);
@@ -152,8 +173,30 @@ class ThreadInfo {
     int priority = 0;
     void *sp;
     int ticks;
+    const char *name = 0;
+    uint32_t created = 0;       // millis() when the thread was added
+    uint64_t cycles = 0;        // CPU cycles spent running, counted at each switch
+    volatile uint8_t wait = 0;  // Threads::WAIT_*: what the thread is blocked on
+    void *tls[THREADS_TLS_SLOTS] = {};
 };
 
+// The running thread's TLS slots, switched with it by getNextThread()
+extern "C" void **currentTls;
+
+// One thread, as copied out by Threads::snapshot()
+typedef struct {
+  int id;
+  const char *name;
+  int state;        // Threads::EMPTY, RUNNING, ...
+  int wait;         // Threads::WAIT_*
+  int priority;     // pending priority slices (mutex hand-over)
+  int ticks;        // time slice
+  uint32_t created; // millis()
+  int stack_size;
+  int stack_peak;   // -1 for thread 0 (see getStackPeak())
+  uint64_t cycles;
+} ThreadSnapshot;
+
 extern "C" void unused_isr(void);
 
 typedef void (*ThreadFunction)(void*);
@@ -188,6 +231,13 @@ public:
   static const int ENDING = 3;
   static const int SUSPENDED = 4;
 
+  // What a thread is waiting for (ThreadInfo::wait)
+  static const int WAIT_NONE = 0;
+  static const int WAIT_DELAY = 1;    // delay()
+  static const int WAIT_JOIN = 2;     // wait() for another thread
+  static const int WAIT_MUTEX = 3;    // Mutex::lock()
+  static const int WAIT_MESSAGE = 4;  // a mailbox or other library wait (setWaitReason())
+
   static const int SVC_NUMBER = 0x21;
   static const int SVC_NUMBER_ACTIVE = 0x22;
 
@@ -216,7 +266,8 @@ public:
   Threads();
 
   // Create a new thread for function "p", passing argument "arg". If stack is 0,
-  // stack allocated on heap. Function "p" has form "void p(void *)".
+  // a stack of up to THREADS_STACK_BLOCK_SIZE bytes is taken from the stack pool.
+  // Returns -1 if no slot or stack is available. Function "p" has form "void p(void *)".
   int addThread(ThreadFunction p, void * arg=0, int stack_size=-1, void *stack=0);
   // For: void f(int)
   int addThread(ThreadFunctionInt p, int arg=0, int stack_size=-1, void *stack=0) {
@@ -244,8 +295,9 @@ public:
   void setTimeSlice(int id, unsigned int ticks);
   // Set the slice length time in ticks for all new threads (1 tick = 1 millisecond, unless using MicroTimer)
   void setDefaultTimeSlice(unsigned int ticks);
-  // Set the stack size for new threads in bytes
-  void setDefaultStackSize(unsigned int bytes_size);
+  // Set the stack size for new threads in bytes; returns 0, keeping the old size, above
+  // THREADS_STACK_BLOCK_SIZE (pooled stacks cannot be bigger)
+  int setDefaultStackSize(unsigned int bytes_size);
   // Use the microsecond timer provided by IntervalTimer & PIT; instead of 1 tick = 1 millisecond,
   // 1 tick will be the number of microseconds provided (default is 100 microseconds)
   int setMicroTimer(int tick_microseconds = DEFAULT_TICK_MICROSECONDS);
@@ -258,6 +310,43 @@ public:
   int id();
   int getStackUsed(int id);
   int getStackRemaining(int id);
+  // Saved stack pointer and stack bounds of a thread, read without locking so that
+  // fault handlers can use it. Returns the thread state (EMPTY for an unused slot).
+  int getStackInfo(int id, void **sp, uint8_t **stack, int *stack_size);
+  // Deepest the thread's stack has been, in bytes, found by how much of the fill is
+  // gone. -1 for thread 0, whose stack is the main stack and is not filled here.
+  int getStackPeak(int id);
+
+  // Name a thread for diagnostics (the string is not copied); thread 0 is "main"
+  void setName(int id, const char *name);
+  const char *getName(int id);
+  // Mark what the current thread is about to wait for (WAIT_*), WAIT_NONE when done;
+  // for libraries that block by yielding
+  void setWaitReason(int reason);
+  // Copy every thread in use into 'out' (up to 'max'), returning how many. The fields
+  // are copied with interrupts masked, a few cycles per thread; the stack peaks are
+  // scanned afterwards, with the scheduler running.
+  int snapshot(ThreadSnapshot *out, int max);
+  // Longest run of the scheduler so far, in CPU cycles: the bulk of a context switch, all
+  // of which runs with interrupts masked
+  uint32_t getMaxSwitchCycles();
+
+  // Thread-local storage. tlsKey() hands out one of THREADS_TLS_SLOTS keys for good, or -1
+  // once they are gone; under that key every thread has its own pointer, NULL until it sets
+  // it. The running thread's slots are switched in with it, so tlsGet() and tlsSet() are a
+  // bounds check and a single load or store, need no lock and never allocate. With a key
+  // out of range (such as the -1 of a tlsKey() that ran out), tlsGet() returns NULL and
+  // tlsSet() returns 0 and stores nothing. An ISR sees the slots of the thread it
+  // interrupted.
+  int tlsKey();
+  void *tlsGet(int key) { return (unsigned)key < THREADS_TLS_SLOTS ? currentTls[key] : 0; }
+  template <typename T>
+  T *tlsGet(int key) { return static_cast<T *>(tlsGet(key)); }
+  int tlsSet(int key, void *value) {
+    if ((unsigned)key >= THREADS_TLS_SLOTS) return 0;
+    currentTls[key] = value;
+    return 1;
+  }
 
   // Give a thread running priority so that it will run on the next context switch for
   // 'ticks' number of slices; used internally by locking mechanism
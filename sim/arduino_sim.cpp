@@ -0,0 +1,346 @@
+/*
+ * arduino_sim.cpp - simulation HAL implementation (see sim/include/sim.h).
+ */
+
+#include <Arduino.h>
+#include "sim.h"
+
+#include <stdio.h>
+
+usb_serial_class Serial;
+HardwareSerial Serial1;
+
+static uint64_t clockMicros;
+
+static uint8_t pinLevel[CORE_NUM_DIGITAL];
+static uint8_t pinModes[CORE_NUM_DIGITAL];
+static int analogValue[CORE_NUM_ANALOG_INPUTS];
+
+struct PinInterrupt {
+  void (*function)(void);
+  int mode;
+};
+static PinInterrupt pinInterrupt[CORE_NUM_DIGITAL];
+static void (*pinChangeCallback)(uint8_t pin, uint8_t level);
+
+struct TimerSlot {
+  void (*function)();
+  uint32_t period;
+  uint64_t deadline;
+  bool active;
+};
+static TimerSlot timers[IntervalTimer::NUM_TIMERS];
+
+static bool serialEcho = true;
+static void (*serialCapture)(const uint8_t *data, size_t len);
+static uint8_t serialRx[4096];
+static size_t serialRxHead, serialRxTail;
+
+static void (*uartCapture)(const uint8_t *data, size_t len);
+static uint8_t uartRx[4096];
+static size_t uartRxHead, uartRxTail;
+
+void simReset() {
+  clockMicros = 0;
+  memset(pinLevel, 0, sizeof(pinLevel));
+  memset(pinModes, 0, sizeof(pinModes));
+  memset(analogValue, 0, sizeof(analogValue));
+  memset(pinInterrupt, 0, sizeof(pinInterrupt));
+  memset(timers, 0, sizeof(timers));
+  pinChangeCallback = 0;
+  serialRxHead = serialRxTail = 0;
+  uartRxHead = uartRxTail = 0;
+}
+
+uint64_t simMicros() {
+  return clockMicros;
+}
+
+void simAdvanceTo(uint64_t target) {
+  while (1) {
+    // the earliest timer due before the target runs first; ties go to the lower slot,
+    // which matches the PIT channel priority on the real part
+    int next = -1;
+    for (int i = 0; i < IntervalTimer::NUM_TIMERS; i++) {
+      if (timers[i].active && timers[i].deadline <= target &&
+          (next < 0 || timers[i].deadline < timers[next].deadline)) {
+        next = i;
+      }
+    }
+    if (next < 0) break;
+    if (timers[next].deadline > clockMicros) clockMicros = timers[next].deadline;
+    timers[next].deadline += timers[next].period;
+    timers[next].function();
+  }
+  if (target > clockMicros) clockMicros = target;
+}
+
+void simAdvance(uint32_t microseconds) {
+  simAdvanceTo(clockMicros + microseconds);
+}
+
+void simSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= CORE_NUM_DIGITAL) return;
+  level = level ? HIGH : LOW;
+  if (pinLevel[pin] == level) return;
+  pinLevel[pin] = level;
+  PinInterrupt &irq = pinInterrupt[pin];
+  if (!irq.function) return;
+  if (irq.mode == CHANGE || (irq.mode == RISING && level == HIGH) ||
+      (irq.mode == FALLING && level == LOW)) {
+    irq.function();
+  }
+}
+
+uint8_t simGetPin(uint8_t pin) {
+  return pin < CORE_NUM_DIGITAL ? pinLevel[pin] : LOW;
+}
+
+void simOnPinChange(void (*callback)(uint8_t pin, uint8_t level)) {
+  pinChangeCallback = callback;
+}
+
+void simSerialEcho(bool enable) {
+  serialEcho = enable;
+}
+
+void simSerialInput(const uint8_t *data, size_t len) {
+  while (len--) {
+    size_t next = (serialRxHead + 1) % sizeof(serialRx);
+    if (next == serialRxTail) return; // full: drop, like an overrun
+    serialRx[serialRxHead] = *data++;
+    serialRxHead = next;
+  }
+}
+
+void simSerialCapture(void (*callback)(const uint8_t *data, size_t len)) {
+  serialCapture = callback;
+}
+
+void simUartInput(const uint8_t *data, size_t len) {
+  while (len--) {
+    size_t next = (uartRxHead + 1) % sizeof(uartRx);
+    if (next == uartRxTail) return; // full: drop, like an overrun
+    uartRx[uartRxHead] = *data++;
+    uartRxHead = next;
+  }
+}
+
+void simUartCapture(void (*callback)(const uint8_t *data, size_t len)) {
+  uartCapture = callback;
+}
+
+void simSetAnalog(uint8_t pin, int value) {
+  if (pin < CORE_NUM_ANALOG_INPUTS) analogValue[pin] = value;
+}
+
+/*
+ * Core API
+ * ==========================================================================================
+ */
+
+extern "C" {
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= CORE_NUM_DIGITAL) return;
+  pinModes[pin] = mode;
+  if (mode == INPUT_PULLUP) pinLevel[pin] = HIGH;
+  else if (mode == INPUT_PULLDOWN) pinLevel[pin] = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= CORE_NUM_DIGITAL) return;
+  val = val ? HIGH : LOW;
+  if (pinLevel[pin] == val) return;
+  pinLevel[pin] = val;
+  if (pinChangeCallback) pinChangeCallback(pin, val);
+}
+
+uint8_t digitalRead(uint8_t pin) {
+  return simGetPin(pin);
+}
+
+void attachInterrupt(uint8_t pin, void (*function)(void), int mode) {
+  if (pin >= CORE_NUM_DIGITAL) return;
+  pinInterrupt[pin].function = function;
+  pinInterrupt[pin].mode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin >= CORE_NUM_DIGITAL) return;
+  pinInterrupt[pin].function = 0;
+}
+
+uint32_t millis(void) {
+  return (uint32_t)(clockMicros / 1000);
+}
+
+uint32_t micros(void) {
+  return (uint32_t)clockMicros;
+}
+
+void delay(uint32_t msec) {
+  simAdvance(msec * 1000);
+}
+
+void delayMicroseconds(uint32_t usec) {
+  simAdvance(usec);
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value) {
+  if (bitOrder == LSBFIRST) shiftOut_lsbFirst(dataPin, clockPin, value);
+  else shiftOut_msbFirst(dataPin, clockPin, value);
+}
+
+void shiftOut_lsbFirst(uint8_t dataPin, uint8_t clockPin, uint8_t value) {
+  for (uint8_t mask = 0x01; mask; mask <<= 1) {
+    digitalWrite(dataPin, value & mask);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+void shiftOut_msbFirst(uint8_t dataPin, uint8_t clockPin, uint8_t value) {
+  for (uint8_t mask = 0x80; mask; mask >>= 1) {
+    digitalWrite(dataPin, value & mask);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+int analogRead(uint8_t pin) {
+  return pin < CORE_NUM_ANALOG_INPUTS ? analogValue[pin] : 0;
+}
+
+void yield(void) {
+}
+
+} // extern "C"
+
+/*
+ * IntervalTimer
+ * ==========================================================================================
+ */
+
+bool IntervalTimer::begin(void (*funct)(), unsigned int microseconds) {
+  if (microseconds == 0) return false;
+  if (slot < 0) {
+    for (int i = 0; i < NUM_TIMERS; i++) {
+      if (!timers[i].active) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot < 0) return false;
+  }
+  timers[slot].function = funct;
+  timers[slot].period = microseconds;
+  timers[slot].deadline = clockMicros + microseconds;
+  timers[slot].active = true;
+  return true;
+}
+
+void IntervalTimer::update(unsigned int microseconds) {
+  // takes effect after the current period, as on the PIT
+  if (slot >= 0 && microseconds) timers[slot].period = microseconds;
+}
+
+void IntervalTimer::end() {
+  if (slot < 0) return;
+  timers[slot].active = false;
+  slot = -1;
+}
+
+/*
+ * Print / Stream / Serial
+ * ==========================================================================================
+ */
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printNumber(unsigned long long n, int base, bool sign) {
+  char buf[66];
+  char *p = buf + sizeof(buf);
+  bool negative = sign && (long long)n < 0;
+  if (negative) n = -(long long)n;
+  if (base < 2) base = 10;
+  do {
+    int digit = n % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  if (negative) *--p = '-';
+  return write((const uint8_t *)p, buf + sizeof(buf) - p);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write((const uint8_t *)buf, len);
+}
+
+int Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len > (int)sizeof(buf) - 1) len = sizeof(buf) - 1;
+  return write((const uint8_t *)buf, len);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length && available()) {
+    *buffer++ = (char)read();
+    count++;
+  }
+  return count;
+}
+
+int usb_serial_class::available() {
+  return (int)((serialRxHead + sizeof(serialRx) - serialRxTail) % sizeof(serialRx));
+}
+
+int usb_serial_class::read() {
+  if (serialRxHead == serialRxTail) return -1;
+  uint8_t b = serialRx[serialRxTail];
+  serialRxTail = (serialRxTail + 1) % sizeof(serialRx);
+  return b;
+}
+
+int usb_serial_class::peek() {
+  if (serialRxHead == serialRxTail) return -1;
+  return serialRx[serialRxTail];
+}
+
+size_t usb_serial_class::write(const uint8_t *buffer, size_t size) {
+  if (serialEcho) fwrite(buffer, 1, size, stdout);
+  if (serialCapture) serialCapture(buffer, size);
+  return size;
+}
+
+int HardwareSerial::available() {
+  return (int)((uartRxHead + sizeof(uartRx) - uartRxTail) % sizeof(uartRx));
+}
+
+int HardwareSerial::read() {
+  if (uartRxHead == uartRxTail) return -1;
+  uint8_t b = uartRx[uartRxTail];
+  uartRxTail = (uartRxTail + 1) % sizeof(uartRx);
+  return b;
+}
+
+int HardwareSerial::peek() {
+  if (uartRxHead == uartRxTail) return -1;
+  return uartRx[uartRxTail];
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (uartCapture) uartCapture(buffer, size);
+  return size;
+}
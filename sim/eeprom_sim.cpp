@@ -0,0 +1,278 @@
+/*
+ * eeprom_sim.cpp - EEPROM emulation for host builds.
+ *
+ * The backing file holds a small header, the EEPROM contents and one 32-bit
+ * write counter per cell, and is memory-mapped so that the contents and the
+ * wear history survive between runs exactly like the real part does between
+ * power cycles:
+ *
+ *   offset 0                    eeprom_sim_header_t
+ *   offset sizeof(header)       uint8_t  data[E2END + 1]
+ *   followed by                 uint32_t writes[E2END + 1]
+ *
+ * Like the Teensy core, a write only reaches the "flash" when the value
+ * differs from what is stored, so only those writes count as wear and pay
+ * the modeled latency.
+ */
+
+#include <avr/eeprom.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define EEPROM_SIM_SIZE (E2END + 1)
+#define EEPROM_SIM_MAGIC "HSEEPROM"
+#define EEPROM_SIM_VERSION 1
+#define EEPROM_SIM_DEFAULT_FILE "hotshot-eeprom.bin"
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+} eeprom_sim_header_t;
+
+typedef struct {
+  eeprom_sim_header_t header;
+  uint8_t data[EEPROM_SIM_SIZE];
+  uint32_t writes[EEPROM_SIM_SIZE];
+} eeprom_sim_file_t;
+
+static eeprom_sim_file_t *image;
+static int image_fd = -1;
+
+static uint32_t write_latency_us;
+static uint64_t total_writes;
+static uint64_t skipped_writes;
+static uint64_t total_latency_us;
+
+static void sleep_latency(uint32_t us)
+{
+  struct timespec ts;
+  ts.tv_sec = us / 1000000;
+  ts.tv_nsec = (long)(us % 1000000) * 1000;
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}
+
+static void (*latency_hook)(uint32_t) = sleep_latency;
+
+int eeprom_sim_open(const char *path)
+{
+  eeprom_sim_close();
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  bool fresh = (size_t)st.st_size != sizeof(eeprom_sim_file_t);
+  if (fresh && ftruncate(fd, sizeof(eeprom_sim_file_t)) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  void *p = mmap(NULL, sizeof(eeprom_sim_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  image = (eeprom_sim_file_t *)p;
+  image_fd = fd;
+
+  if (fresh || memcmp(image->header.magic, EEPROM_SIM_MAGIC, 8) != 0 ||
+      image->header.version != EEPROM_SIM_VERSION || image->header.size != EEPROM_SIM_SIZE) {
+    // unknown or resized file: start from an erased part with no wear
+    memcpy(image->header.magic, EEPROM_SIM_MAGIC, 8);
+    image->header.version = EEPROM_SIM_VERSION;
+    image->header.size = EEPROM_SIM_SIZE;
+    memset(image->data, 0xFF, sizeof(image->data));
+    memset(image->writes, 0, sizeof(image->writes));
+  }
+  total_writes = 0;
+  skipped_writes = 0;
+  total_latency_us = 0;
+  return 0;
+}
+
+void eeprom_sim_close(void)
+{
+  if (!image) return;
+  msync(image, sizeof(eeprom_sim_file_t), MS_SYNC);
+  munmap(image, sizeof(eeprom_sim_file_t));
+  close(image_fd);
+  image = NULL;
+  image_fd = -1;
+}
+
+void eeprom_initialize(void)
+{
+  if (image) return;
+  const char *path = getenv("HOTSHOT_EEPROM_FILE");
+  if (eeprom_sim_open(path ? path : EEPROM_SIM_DEFAULT_FILE) != 0) {
+    fprintf(stderr, "eeprom_sim: cannot map %s: %s\n",
+            path ? path : EEPROM_SIM_DEFAULT_FILE, strerror(errno));
+    abort();
+  }
+}
+
+static inline uint32_t cell(const void *addr)
+{
+  return (uint32_t)(uintptr_t)addr;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+  uint32_t offset = cell(addr);
+  if (offset > E2END) return 0;
+  eeprom_initialize();
+  return image->data[offset];
+}
+
+uint16_t eeprom_read_word(const uint16_t *addr)
+{
+  uint16_t value;
+  eeprom_read_block(&value, addr, sizeof(value));
+  return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *addr)
+{
+  uint32_t value;
+  eeprom_read_block(&value, addr, sizeof(value));
+  return value;
+}
+
+void eeprom_read_block(void *buf, const void *addr, uint32_t len)
+{
+  uint8_t *p = (uint8_t *)buf;
+  uint32_t offset = cell(addr);
+  while (len--) *p++ = eeprom_read_byte((const uint8_t *)(uintptr_t)offset++);
+}
+
+int eeprom_is_ready(void)
+{
+  return 1;
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value)
+{
+  uint32_t offset = cell(addr);
+  if (offset > E2END) return;
+  eeprom_initialize();
+  if (image->data[offset] == value) {
+    skipped_writes++;
+    return;
+  }
+  image->data[offset] = value;
+  image->writes[offset]++;
+  total_writes++;
+  if (write_latency_us) {
+    total_latency_us += write_latency_us;
+    latency_hook(write_latency_us);
+  }
+}
+
+void eeprom_write_word(uint16_t *addr, uint16_t value)
+{
+  eeprom_write_block(&value, addr, sizeof(value));
+}
+
+void eeprom_write_dword(uint32_t *addr, uint32_t value)
+{
+  eeprom_write_block(&value, addr, sizeof(value));
+}
+
+void eeprom_write_block(const void *buf, void *addr, uint32_t len)
+{
+  const uint8_t *p = (const uint8_t *)buf;
+  uint32_t offset = cell(addr);
+  while (len--) eeprom_write_byte((uint8_t *)(uintptr_t)offset++, *p++);
+}
+
+void eeprom_sim_set_write_latency(uint32_t microseconds)
+{
+  write_latency_us = microseconds;
+}
+
+void eeprom_sim_set_latency_hook(void (*hook)(uint32_t microseconds))
+{
+  latency_hook = hook ? hook : sleep_latency;
+}
+
+uint32_t eeprom_sim_write_count(uint32_t addr)
+{
+  if (addr > E2END) return 0;
+  eeprom_initialize();
+  return image->writes[addr];
+}
+
+uint64_t eeprom_sim_total_writes(void)
+{
+  return total_writes;
+}
+
+uint64_t eeprom_sim_skipped_writes(void)
+{
+  return skipped_writes;
+}
+
+uint64_t eeprom_sim_total_latency(void)
+{
+  return total_latency_us;
+}
+
+void eeprom_sim_reset_wear(void)
+{
+  eeprom_initialize();
+  memset(image->writes, 0, sizeof(image->writes));
+  total_writes = 0;
+  skipped_writes = 0;
+  total_latency_us = 0;
+}
+
+void eeprom_sim_report(FILE *out, unsigned top, uint32_t endurance, double simulated_days)
+{
+  eeprom_initialize();
+
+  // selection of the 'top' hottest cells; EEPROM is only 2K so this is cheap
+  uint16_t order[EEPROM_SIM_SIZE];
+  unsigned used = 0;
+  for (uint32_t i = 0; i < EEPROM_SIM_SIZE; i++) {
+    if (image->writes[i]) order[used++] = (uint16_t)i;
+  }
+  if (top > used) top = used;
+  for (unsigned i = 0; i < top; i++) {
+    unsigned best = i;
+    for (unsigned j = i + 1; j < used; j++) {
+      if (image->writes[order[j]] > image->writes[order[best]]) best = j;
+    }
+    uint16_t t = order[i]; order[i] = order[best]; order[best] = t;
+  }
+
+  fprintf(out, "EEPROM wear: %u of %u cells written, %llu writes committed, %llu unchanged writes skipped\n",
+          used, EEPROM_SIM_SIZE, (unsigned long long)total_writes, (unsigned long long)skipped_writes);
+  if (total_latency_us) {
+    fprintf(out, "Modeled write latency: %llu us total\n", (unsigned long long)total_latency_us);
+  }
+  if (!top) return;
+
+  fprintf(out, "%8s %12s %12s %14s\n", "address", "writes", "% endurance", "years to limit");
+  for (unsigned i = 0; i < top; i++) {
+    uint32_t writes = image->writes[order[i]];
+    double pct = endurance ? 100.0 * writes / endurance : 0.0;
+    fprintf(out, "  0x%04X %12u %11.3f%%", order[i], writes, pct);
+    if (simulated_days > 0 && endurance) {
+      fprintf(out, " %14.1f\n", (endurance / (writes / simulated_days)) / 365.0);
+    } else {
+      fprintf(out, " %14s\n", "-");
+    }
+  }
+}
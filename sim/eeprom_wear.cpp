@@ -0,0 +1,79 @@
+/*
+ * eeprom_wear.cpp - simulate a period of cabinet operation against the host
+ * EEPROM emulator and report which cells wear fastest.
+ *
+ * usage: eeprom-wear [-d days] [-b boots/day] [-g games/day] [-t top]
+ *                    [-e endurance] [-l latency_us] [-f file]
+ *
+ * The workload is the firmware's own setupEEPROM() on every power-up plus a
+ * high score update whenever a game beats it.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include "sim.h"
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void bootWorkload() {
+  setupEEPROM();
+}
+
+static void gameWorkload(uint8_t score) {
+  if (score > highScore) {
+    configSet(CFG_HIGH_SCORE, score); // also rewrites the settings CRC
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned days = 365, bootsPerDay = 2, gamesPerDay = 120, top = 10;
+  uint32_t endurance = 100000, latency = 0;
+  const char *file = "eeprom-wear.bin";
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:b:g:t:e:l:f:h")) != -1) {
+    switch (opt) {
+      case 'd': days = atoi(optarg); break;
+      case 'b': bootsPerDay = atoi(optarg); break;
+      case 'g': gamesPerDay = atoi(optarg); break;
+      case 't': top = atoi(optarg); break;
+      case 'e': endurance = strtoul(optarg, NULL, 0); break;
+      case 'l': latency = strtoul(optarg, NULL, 0); break;
+      case 'f': file = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-d days] [-b boots/day] [-g games/day] [-t top] "
+                        "[-e endurance] [-l latency_us] [-f file]\n", argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  unlink(file); // every run starts from a factory-fresh part
+  if (eeprom_sim_open(file) != 0) {
+    perror(file);
+    return 1;
+  }
+  eeprom_sim_set_write_latency(latency);
+  simSerialEcho(false);
+
+  // deterministic scores: mostly ordinary games with the occasional record
+  uint32_t seed = 12345;
+  for (unsigned day = 0; day < days; day++) {
+    for (unsigned boot = 0; boot < bootsPerDay; boot++) {
+      bootWorkload();
+      unsigned share = gamesPerDay / bootsPerDay + (boot < gamesPerDay % bootsPerDay ? 1 : 0);
+      for (unsigned g = 0; g < share; g++) {
+        seed = seed * 1103515245 + 12345;
+        gameWorkload((seed >> 16) % 30);
+      }
+    }
+  }
+
+  printf("Simulated %u days, %u boots/day, %u games/day\n", days, bootsPerDay, gamesPerDay);
+  eeprom_sim_report(stdout, top, endurance, days);
+  eeprom_sim_close();
+  return 0;
+}
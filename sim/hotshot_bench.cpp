@@ -0,0 +1,318 @@
+/*
+ * hotshot_bench.cpp - run the firmware's microbenchmarks (src/benchmarks.h)
+ * on the host and check them against a baseline report.
+ *
+ * usage: hotshot-bench [-r reps] [-f filter] [-o out.json] [-b baseline.json] [-T percent]
+ *        hotshot-bench -c results.json -b baseline.json [-T percent]
+ *        hotshot-bench [-c results.json] -B baseline.json
+ *        hotshot-bench -l
+ *
+ * Every benchmark whose name contains the filter runs -r times (default
+ * BENCH_DEFAULT_REPS) after calibration; the JSON report (lib/Bench) goes
+ * to -o, or to stdout.
+ *
+ * -b compares the minimums with a baseline report and prints the change of
+ * each on stderr. A benchmark more than -T percent slower than its baseline
+ * is a regression. -c compares an existing report instead of running, e.g.
+ * one captured from a HOTSHOT_BENCH firmware over USB, whose baseline is
+ * then a report from the cabinet too. Benchmarks missing from either report
+ * are listed but never fail the run.
+ *
+ * Absolute timings only mean something on the machine and compiler that
+ * produced them, so the baseline kept in the tree, sim/bench_baseline.json,
+ * holds ratios instead: each minimum divided by the geometric mean of all the
+ * minimums of the same run. Comparing with a ratio baseline scales the
+ * current minimums the same way first (over the benchmarks both have), so a
+ * faster or slower machine cancels out and only a change in one hot path
+ * relative to the rest shows. -B writes such a baseline from a run, or from
+ * a report with -c:
+ *
+ *   hotshot-bench -b sim/bench_baseline.json       # check a change
+ *   hotshot-bench -B sim/bench_baseline.json       # accept a new baseline
+ *
+ * The ratios move with the compiler and the CPU's caches and branch
+ * predictors, and the shortest benchmarks with the noise of the machine, so
+ * against a ratio baseline only a slowdown over RATIO_THRESHOLD counts by
+ * default: a hot path gone half as slow again, not a few percent. For those,
+ * compare in ns with a plain report made before the change on the same
+ * machine (or the cabinet), where the default is SAME_MACHINE_THRESHOLD:
+ *
+ *   hotshot-bench -o before.json                   # before
+ *   hotshot-bench -b before.json                   # after
+ *
+ * Exit status: 0 if nothing regressed, 1 on a regression or an error.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include "sim.h"
+
+#include <Bench.h>
+
+#include "benchmarks.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_RESULTS 64
+#define NAME_MAX_LEN 48
+#define SAME_MACHINE_THRESHOLD 25 // percent, default -T against a plain report
+#define RATIO_THRESHOLD 50        // percent, default -T against a ratio baseline
+
+typedef struct {
+  char name[NAME_MAX_LEN];
+  double min;     // ns/op, the figure compared
+} Result;
+
+// Collects the report in memory, to be written out and compared
+class TextPrint : public Print {
+public:
+  char *text = NULL;
+  size_t len = 0, size = 0;
+  ~TextPrint() { free(text); }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *buffer, size_t n) override {
+    if (len + n + 1 > size) {
+      size = (len + n + 1) * 2;
+      text = (char *)realloc(text, size);
+    }
+    memcpy(text + len, buffer, n);
+    len += n;
+    text[len] = 0;
+    return n;
+  }
+};
+
+static char *readFile(const char *file) {
+  FILE *f = fopen(file, "r");
+  if (!f) return NULL;
+  TextPrint buf;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.write(chunk, n);
+  fclose(f);
+  char *text = buf.text ? buf.text : strdup("");
+  buf.text = NULL;
+  return text;
+}
+
+// Copy the string value of "key" on 'line' (up to its closing quote); false if absent
+static bool stringField(const char *line, const char *key, char *out, size_t size) {
+  char pattern[32];
+  snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+  const char *p = strstr(line, pattern);
+  if (!p) return false;
+  p += strlen(pattern);
+  size_t n = 0;
+  while (p[n] && p[n] != '"' && p[n] != '\n' && n + 1 < size) {
+    out[n] = p[n];
+    n++;
+  }
+  out[n] = 0;
+  return true;
+}
+
+// The benchmarks of a report, one per line (Bench.h); returns how many
+static int parseResults(const char *text, Result *out, int max, char *platform, size_t platformSize) {
+  int count = 0;
+  platform[0] = 0;
+  for (const char *line = text; *line;) {
+    size_t len = strcspn(line, "\n");
+    char buf[256];
+    size_t n = len < sizeof(buf) ? len : sizeof(buf) - 1;
+    memcpy(buf, line, n);
+    buf[n] = 0;
+    line += len;
+    if (*line) line++;
+
+    if (!platform[0]) stringField(buf, "platform", platform, platformSize);
+    const char *min = strstr(buf, "\"min\": ");
+    if (count < max && min && stringField(buf, "name", out[count].name, NAME_MAX_LEN)) {
+      out[count].min = strtod(min + strlen("\"min\": "), NULL);
+      count++;
+    }
+  }
+  return count;
+}
+
+static const Result *findResult(const Result *results, int count, const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (!strcmp(results[i].name, name)) return &results[i];
+  }
+  return NULL;
+}
+
+// Divide every minimum by the geometric mean of those also in 'other' (all if NULL);
+// false if there are none
+static bool normalize(Result *results, int count, const Result *other, int otherCount) {
+  double logSum = 0;
+  int n = 0;
+  for (int i = 0; i < count; i++) {
+    if (results[i].min <= 0 || (other && !findResult(other, otherCount, results[i].name))) continue;
+    logSum += log(results[i].min);
+    n++;
+  }
+  if (!n) return false;
+  double scale = exp(logSum / n);
+  for (int i = 0; i < count; i++) results[i].min /= scale;
+  return true;
+}
+
+// Write the ratio baseline of a report
+static bool writeBaseline(const char *text, const char *file) {
+  static Result results[MAX_RESULTS];
+  char platform[32];
+  int n = parseResults(text, results, MAX_RESULTS, platform, sizeof(platform));
+  if (!normalize(results, n, NULL, 0)) {
+    fprintf(stderr, "no benchmarks in the report\n");
+    return false;
+  }
+  FILE *out = fopen(file, "w");
+  if (!out) {
+    perror(file);
+    return false;
+  }
+  fprintf(out, "{\"platform\": \"%s\", \"unit\": \"ratio\", \"benchmarks\": [", platform);
+  for (int i = 0; i < n; i++) {
+    fprintf(out, "%s{\"name\": \"%s\", \"min\": %.4f}", i ? ",\n  " : "\n  ", results[i].name, results[i].min);
+  }
+  fprintf(out, "\n]}\n");
+  fclose(out);
+  return true;
+}
+
+// Print the comparison on stderr; returns the number of regressions, -1 on an error
+static int compare(const char *currentText, const char *baselineText, double thresholdPercent) {
+  static Result current[MAX_RESULTS], baseline[MAX_RESULTS];
+  char currentPlatform[32], baselinePlatform[32], unit[16];
+  int nCurrent = parseResults(currentText, current, MAX_RESULTS, currentPlatform, sizeof(currentPlatform));
+  int nBaseline = parseResults(baselineText, baseline, MAX_RESULTS, baselinePlatform, sizeof(baselinePlatform));
+  int regressions = 0;
+
+  if (strcmp(currentPlatform, baselinePlatform)) {
+    fprintf(stderr, "warning: comparing platform '%s' with a '%s' baseline\n",
+            currentPlatform, baselinePlatform);
+  }
+  // a ratio baseline (-B): scale both over the benchmarks they share, so that a filtered
+  // run or one from the cabinet (which has its own set) still lines up
+  bool ratios = stringField(baselineText, "unit", unit, sizeof(unit)) && !strcmp(unit, "ratio");
+  if (thresholdPercent < 0) thresholdPercent = ratios ? RATIO_THRESHOLD : SAME_MACHINE_THRESHOLD;
+  if (ratios && (!normalize(current, nCurrent, baseline, nBaseline) ||
+                 !normalize(baseline, nBaseline, current, nCurrent))) {
+    fprintf(stderr, "no benchmark in common with the baseline\n");
+    return -1;
+  }
+  fprintf(stderr, "%-24s %12s %12s %9s\n", "benchmark", "baseline", "current", "change");
+  for (int i = 0; i < nCurrent; i++) {
+    const Result *b = findResult(baseline, nBaseline, current[i].name);
+    if (!b || b->min <= 0) {
+      fprintf(stderr, "%-24s %12s %12.4f %9s\n", current[i].name, "-", current[i].min, "new");
+      continue;
+    }
+    double change = (current[i].min - b->min) * 100 / b->min;
+    bool regressed = change > thresholdPercent;
+    if (regressed) regressions++;
+    fprintf(stderr, "%-24s %12.4f %12.4f %+8.1f%%%s\n", current[i].name, b->min,
+            current[i].min, change, regressed ? "  REGRESSION" : "");
+  }
+  for (int i = 0; i < nBaseline; i++) {
+    if (!findResult(current, nCurrent, baseline[i].name)) {
+      fprintf(stderr, "%-24s %12.4f %12s %9s\n", baseline[i].name, baseline[i].min, "-", "missing");
+    }
+  }
+  fprintf(stderr, "%d regression%s over %.0f%% (%s)\n", regressions, regressions == 1 ? "" : "s",
+          thresholdPercent, ratios ? "min / geometric mean" : "ns/op, min");
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  unsigned reps = BENCH_DEFAULT_REPS;
+  const char *filter = NULL, *outFile = NULL, *baselineFile = NULL, *resultsFile = NULL;
+  const char *newBaselineFile = NULL;
+  double threshold = -1; // by the kind of baseline
+  bool list = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "r:f:o:b:T:c:B:lh")) != -1) {
+    switch (opt) {
+      case 'r': reps = atoi(optarg); break;
+      case 'f': filter = optarg; break;
+      case 'o': outFile = optarg; break;
+      case 'b': baselineFile = optarg; break;
+      case 'T': threshold = atof(optarg); break;
+      case 'c': resultsFile = optarg; break;
+      case 'B': newBaselineFile = optarg; break;
+      case 'l': list = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-r reps] [-f filter] [-o out.json] [-b baseline.json] [-T percent]\n"
+                        "       %s -c results.json -b baseline.json [-T percent]\n"
+                        "       %s [-c results.json] -B baseline.json\n"
+                        "       %s -l\n", argv[0], argv[0], argv[0], argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (reps < 1 || reps > BENCH_MAX_REPS) {
+    fprintf(stderr, "reps must be 1..%d\n", BENCH_MAX_REPS);
+    return 1;
+  }
+  if (resultsFile && !baselineFile && !newBaselineFile) {
+    fprintf(stderr, "-c needs a baseline (-b or -B)\n");
+    return 1;
+  }
+  if (list) {
+    for (Bench *b = Bench::first(); b; b = b->next()) printf("%s\n", b->name());
+    return 0;
+  }
+
+  char *baseline = NULL;
+  if (baselineFile && !(baseline = readFile(baselineFile))) {
+    perror(baselineFile);
+    return 1;
+  }
+
+  TextPrint report;
+  char *current = NULL;
+  if (resultsFile) {
+    if (!(current = readFile(resultsFile))) {
+      perror(resultsFile);
+      return 1;
+    }
+  } else {
+    // a factory-fresh EEPROM that the benchmarks may wear as they like
+    char eepromFile[] = "/tmp/hotshot-bench-XXXXXX";
+    int fd = mkstemp(eepromFile);
+    if (fd < 0 || eeprom_sim_open(eepromFile) != 0) {
+      perror(eepromFile);
+      return 1;
+    }
+    close(fd);
+    unlink(eepromFile);
+
+    simReset();
+    simSerialEcho(false);
+    setupBench();
+    if (!bench_report(report, BENCH_PLATFORM, reps, filter)) {
+      fprintf(stderr, "no benchmark matches '%s'\n", filter ? filter : "");
+      return 1;
+    }
+    current = report.text;
+
+    FILE *out = outFile ? fopen(outFile, "w") : stdout;
+    if (!out) {
+      perror(outFile);
+      return 1;
+    }
+    fwrite(report.text, 1, report.len, out);
+    if (out != stdout) fclose(out);
+  }
+
+  int status = 0;
+  if (baseline) status = compare(current, baseline, threshold) ? 1 : 0;
+  if (newBaselineFile && !writeBaseline(current, newBaselineFile)) status = 1;
+  free(baseline);
+  if (resultsFile) free(current);
+  return status;
+}
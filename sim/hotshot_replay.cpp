@@ -0,0 +1,244 @@
+/*
+ * hotshot_replay.cpp - replay a recorded session (src/record.h) through the
+ * game engine in virtual time and check that it reproduces the recording.
+ *
+ * usage: hotshot-replay [-e eeprom-file] [-s step-us] [-T tolerance-us] [-v] recording
+ *        hotshot-replay -c [-T tolerance-us] recording-a recording-b
+ *
+ * Recordings are the text produced by hsctl record or hotshot-sim -R. The
+ * inputs (settings, coin and opto edges) are applied at their recorded
+ * times by driving the simulated pins, so the real ISRs run; the game timer
+ * ticks and state transitions the engine produces are then compared, in
+ * order, with the recorded ones.
+ *
+ * The engine is stepped every step-us (default 1 ms, as hotshot-sim does).
+ * A cabinet's game thread runs at its own, uneven rate, and every state
+ * deadline is taken from the moment the thread noticed the previous state,
+ * so replayed timestamps drift from the recorded ones. Each result may add
+ * up to the tolerance (default 10 ms) to that drift.
+ *
+ * -c compares two recordings without simulating, e.g. a session and its
+ * replay on a cabinet (hsctl replay, then hsctl record <from>). Their clocks
+ * are aligned on the first result, and attract timer ticks, which no input
+ * causes, are ignored. -v echoes the game's serial output.
+ *
+ * Exit status: 0 if the results match, 1 if they differ or on error.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include "sim.h"
+
+#include "config.h"
+#include "game.h"
+#include "pins.h"
+#include "record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+
+struct Event {
+  uint64_t micros; // unwrapped
+  uint8_t type;
+  uint8_t id;
+  uint16_t value;
+};
+
+static bool isResult(uint8_t type) {
+  return type == REC_TICK || type == REC_STATE;
+}
+
+static int loadRecording(const char *path, std::vector<Event> &out) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+
+  char line[128], name[16];
+  unsigned long us;
+  unsigned id, value;
+  uint64_t base = 0;
+  uint32_t last = 0;
+  int lineNo = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNo++;
+    if (line[0] == '#' || line[0] == '\n') continue;
+    if (sscanf(line, "%lu %15s %u %u", &us, name, &id, &value) != 4) {
+      fprintf(stderr, "%s:%d: malformed event\n", path, lineNo);
+      fclose(f);
+      return -1;
+    }
+    uint8_t type = REC_TYPE_COUNT;
+    for (uint8_t t = 0; t < REC_TYPE_COUNT; t++) {
+      if (strcmp(name, recordTypeName(t)) == 0) type = t;
+    }
+    if (type == REC_TYPE_COUNT) {
+      fprintf(stderr, "%s:%d: unknown event type '%s'\n", path, lineNo, name);
+      fclose(f);
+      return -1;
+    }
+    if ((uint32_t)us < last) base += 1ULL << 32; // micros() wrapped
+    last = us;
+    out.push_back({ base + (uint32_t)us, type, (uint8_t)id, (uint16_t)value });
+  }
+  fclose(f);
+  return 0;
+}
+
+static void printEvent(const char *label, const Event &e) {
+  fprintf(stderr, "  %s %12.6f s  %s %u %u\n", label, e.micros / 1e6, recordTypeName(e.type), e.id, e.value);
+}
+
+// Compare the results of two event streams; returns 0 if they match
+static int compare(const std::vector<Event> &want, const std::vector<Event> &got, uint32_t tolerance, bool align) {
+  std::vector<Event> a, b;
+  for (const Event &e : want) {
+    if (isResult(e.type) && !(align && e.type == REC_TICK && e.id == REC_ATTRACT)) a.push_back(e);
+  }
+  for (const Event &e : got) {
+    if (isResult(e.type) && !(align && e.type == REC_TICK && e.id == REC_ATTRACT)) b.push_back(e);
+  }
+
+  int64_t offset = align && !a.empty() && !b.empty() ? (int64_t)(b[0].micros - a[0].micros) : 0;
+  int64_t skew = 0, maxSkew = 0;
+  size_t n = a.size() < b.size() ? a.size() : b.size();
+  for (size_t i = 0; i < n; i++) {
+    int64_t s = (int64_t)(b[i].micros - a[i].micros) - offset;
+    bool late = s - skew > (int64_t)tolerance || skew - s > (int64_t)tolerance;
+    skew = s;
+    if (a[i].type != b[i].type || a[i].id != b[i].id || a[i].value != b[i].value || late) {
+      fprintf(stderr, "result %zu differs:\n", i);
+      printEvent("recorded", a[i]);
+      printEvent("replayed", b[i]);
+      return 1;
+    }
+    if (llabs(skew) > maxSkew) maxSkew = llabs(skew);
+  }
+  if (a.size() != b.size()) {
+    fprintf(stderr, "recorded %zu results, replay produced %zu\n", a.size(), b.size());
+    printEvent(a.size() > n ? "missing " : "extra   ", a.size() > n ? a[n] : b[n]);
+    return 1;
+  }
+
+  printf("%zu results match (largest skew %.3f ms)\n", n, maxSkew / 1e3);
+  return 0;
+}
+
+static uint32_t drained;
+
+// Move what the engine recorded since the last call into 'out'
+static void drain(std::vector<Event> &out) {
+  static uint64_t base;
+  static uint32_t last;
+  RecordEvent e;
+  for (; recordGet(drained, &e); drained++) {
+    if (e.micros < last) base += 1ULL << 32;
+    last = e.micros;
+    out.push_back({ base + e.micros, e.type, e.id, e.value });
+  }
+}
+
+static uint32_t stepUs = 1000;
+
+static void step(uint64_t until, std::vector<Event> &out) {
+  while (simMicros() < until) {
+    gameUpdate();
+    gamePoll();
+    drain(out);
+    uint64_t next = simMicros() + stepUs;
+    simAdvanceTo(next < until ? next : until);
+  }
+}
+
+static void inject(const Event &e) {
+  switch (e.type) {
+    case REC_CONFIG:
+      if (configGet(e.id) != e.value && configSet(e.id, e.value)) applySetting(e.id);
+      break;
+    case REC_COIN:
+      simSetPin(COIN1_IN, LOW);
+      simSetPin(COIN1_IN, HIGH); // coin1ISR fires on the rising edge
+      break;
+    case REC_OPTO:
+      simSetPin(e.id == OPTO_UPPER ? UPPER_OPTO_IN : LOWER_OPTO_IN, e.value);
+      break;
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *eepromFile = "hotshot-replay-eeprom.bin";
+  uint32_t tolerance = 10000;
+  bool compareOnly = false, verbose = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "e:s:T:cvh")) != -1) {
+    switch (opt) {
+      case 'e': eepromFile = optarg; break;
+      case 's': stepUs = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+      case 'T': tolerance = atoi(optarg); break;
+      case 'c': compareOnly = true; break;
+      case 'v': verbose = true; break;
+      default:
+        fprintf(stderr,
+                "usage: %s [-e eeprom-file] [-s step-us] [-T tolerance-us] [-v] recording\n"
+                "       %s -c [-T tolerance-us] recording-a recording-b\n",
+                argv[0], argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  std::vector<Event> recorded, replayed;
+  if (optind >= argc || loadRecording(argv[optind], recorded) != 0) return 1;
+
+  if (compareOnly) {
+    if (optind + 1 >= argc || loadRecording(argv[optind + 1], replayed) != 0) return 1;
+    return compare(recorded, replayed, tolerance, true);
+  }
+
+  if (recorded.empty() || recorded[0].type != REC_BOOT) {
+    fprintf(stderr, "%s: recording does not start at boot (did the ring wrap?)\n", argv[optind]);
+    return 1;
+  }
+
+  if (eeprom_sim_open(eepromFile) != 0) {
+    perror(eepromFile);
+    return 1;
+  }
+
+  simReset();
+  simSerialEcho(verbose);
+  eeprom_sim_set_latency_hook(delayMicroseconds);
+
+  setupIO();
+  setupEEPROM();
+  setupRecord();
+  setupTimers();
+
+  struct timespec wallStart, wallEnd;
+  clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+  unsigned inputs = 0;
+  for (const Event &e : recorded) {
+    if (e.type == REC_BOOT || isResult(e.type)) continue;
+    step(e.micros, replayed);
+    inject(e);
+    inputs++;
+  }
+  // run on to where the recording ends, no further: it may stop mid-game
+  step(recorded.back().micros + tolerance + stepUs, replayed);
+
+  clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+  double wallMs = (wallEnd.tv_sec - wallStart.tv_sec) * 1e3 + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e6;
+  printf("replayed %u inputs over %.1f s in %.1f ms (%.0fx real time)\n", inputs, simMicros() / 1e6, wallMs,
+         wallMs > 0 ? simMicros() / 1e3 / wallMs : 0);
+
+  eeprom_sim_close();
+  return compare(recorded, replayed, tolerance, false);
+}
@@ -0,0 +1,421 @@
+/*
+ * hotshot_sim.cpp - run the game engine on the host against the simulation HAL.
+ *
+ * usage: hotshot-sim [-c coins] [-s shots] [-t seconds] [-e eeprom-file] [-L write-us] [-R record-file]
+ *                    [-U pty|device] [-J jam-ms] [-V sag-ms] [-K keys] [-C] [-q] [-p] [-P]
+ *
+ * Inserts the requested number of coins, sinks 'shots' baskets per game
+ * (evenly spread over the play time), runs the cabinet in virtual time
+ * until every credit has been played (or the time limit is hit) and prints
+ * what the outputs did. The firmware's thread structure is replaced by a
+ * single loop that calls gameUpdate()/gamePoll() once per simulated
+ * millisecond, which is what the game thread and loop() amount to.
+ * -p prints the timing probe report at the end. -R writes the input recording
+ * (src/record.h) as text, for hotshot-replay.
+ *
+ * The boot phases (src/boot.h) are reported first. -L gives each EEPROM
+ * write a cost in virtual time, to see what storing settings at boot costs.
+ *
+ * -P serves the USB serial port on a pseudo-terminal instead of stdout, so
+ * tools/hsctl can talk to the simulated cabinet, and paces the simulation at
+ * real time until the time limit.
+ *
+ * -J blocks the upper beam from jam-ms (virtual) for SIM_JAM_MS, to exercise
+ * the opto monitor (src/optomon.h): the game clock holds while it is jammed.
+ *
+ * The supply monitor (src/supply.h) reads a steady SIM_SUPPLY_MV, 3.3 V and 25 C. -V sags
+ * the 12 V rail to SIM_SAG_MV from sag-ms (virtual) for SIM_SAG_MS.
+ *
+ * -K presses the programming buttons from SIM_KEYS_START_MS on, one key every
+ * SIM_KEY_GAP_MS: M holds AUX1 long enough to open or close the operator menu
+ * (src/menu.h), T holds RESET to start or stop the self-test (src/selftest.h),
+ * n clicks AUX1 (next setting), + clicks AUX2 and - RESET. For example
+ * -K M+++n-M raises tickets per score by 3 and plays per credit by -1.
+ *
+ * -U puts the cabinet link (src/link.h) on a new pseudo-terminal ("pty") or on
+ * an existing serial device, such as the pty another hotshot-sim made, for a
+ * head-to-head game between two simulated cabinets. A linked simulation runs at
+ * real time in finer steps, prints the wall-clock time its ball gate opens, and
+ * waits a second after its last game for the opponent's result.
+ *
+ * -C runs the firmware's tasks from the cyclic executive's schedule (src/cyclic.h), as a
+ * HOTSHOT_CYCLIC build does, instead of calling them all every step, and prints the
+ * frame overruns and each task's worst-case execution time at the end.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include "sim.h"
+
+#include "boot.h"
+#include "config.h"
+#include "cyclic.h"
+#include "display.h"
+#include "game.h"
+#include "irq.h"
+#include "link.h"
+#include "menu.h"
+#include "pins.h"
+#include "probes.h"
+#include "record.h"
+#include "selftest.h"
+#include "shots.h"
+#include "statusled.h"
+#include "supply.h"
+#include "telemetry.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_STEP_US 1000
+#define SIM_LINK_STEP_US 100 // linked: fine enough to see the start skew
+#define SIM_LINK_LINGER_MS 1000
+#define COIN_FIRST_MS 3000
+#define COIN_PULSE_MS 50
+#define COIN_SPACING_MS 3000
+#define SHOT_BEAM_MS 20     // time a ball spends in each beam
+#define SHOT_TRANSIT_MS 80  // upper beam to lower beam, for the fastest shot
+#define SIM_JAM_MS 4000     // -J: a ball stuck in the upper beam this long
+#define SIM_SUPPLY_MV 12000
+#define SIM_SAG_MV 9500     // -V: the 12 V rail drops this low
+#define SIM_SAG_MS 2000     // for this long
+#define SIM_VDD_MV 3300
+#define SIM_KEYS_START_MS 500
+#define SIM_KEY_PRESS_MS 100 // a click
+#define SIM_KEY_GAP_MS 300
+#define SHOT_SPREAD_MS 60   // later shots take up to this much longer (src/shots.h)
+
+static unsigned shotsPerGame = 6;
+static unsigned shotsFired;
+static uint32_t gateOpenMillis;
+
+static unsigned ticketPulses, creditPulses, gamesStarted;
+static int linkFd = -1;
+
+static void onPinChange(uint8_t pin, uint8_t level) {
+  if (pin == TICKET_COUNTER_OUT && level == HIGH) ticketPulses++;
+  if (pin == CREDIT_COUNTER_OUT && level == HIGH) creditPulses++;
+  if (pin == BALL_GATE_OUT && level == HIGH) {
+    if (!selfTestActive()) gamesStarted++; // the self-test pulses it too; shoot() plays along
+    gateOpenMillis = millis();
+    shotsFired = 0;
+    if (linkFd >= 0) {
+      struct timespec wall;
+      clock_gettime(CLOCK_REALTIME, &wall);
+      printf("ball gate open at %ld.%06ld\n", (long)wall.tv_sec, wall.tv_nsec / 1000);
+      fflush(stdout);
+    }
+  }
+}
+
+// Drop the next ball through both beams while the gate is open
+static void shoot(uint32_t now) {
+  if (!simGetPin(BALL_GATE_OUT) || shotsFired >= shotsPerGame) return;
+
+  uint32_t interval = playTime * 1000UL / (shotsPerGame + 1);
+  uint32_t t = gateOpenMillis + (shotsFired + 1) * interval;
+  if (now < t) return;
+
+  uint32_t dt = now - t;
+  uint32_t transit = SHOT_TRANSIT_MS + shotsFired * 37 % SHOT_SPREAD_MS;
+  simSetPin(UPPER_OPTO_IN, dt < SHOT_BEAM_MS ? OPTO_BLOCKED : !OPTO_BLOCKED);
+  simSetPin(LOWER_OPTO_IN, dt >= transit && dt < transit + SHOT_BEAM_MS ? OPTO_BLOCKED : !OPTO_BLOCKED);
+  if (dt >= transit + SHOT_BEAM_MS) shotsFired++;
+}
+
+// The supply monitor's channels as the ADC would read them, with the rail at 'mv'
+static void setSupply(uint32_t mv) {
+  simSetAnalog(SUPPLY_SENSE_IN, mv * SUPPLY_DIVIDER_BOTTOM / (SUPPLY_DIVIDER_TOP + SUPPLY_DIVIDER_BOTTOM) *
+                                    SUPPLY_ADC_MAX / SIM_VDD_MV);
+  simSetAnalog(SUPPLY_BANDGAP_CHANNEL, SUPPLY_BANDGAP_MV * SUPPLY_ADC_MAX / SIM_VDD_MV);
+  simSetAnalog(SUPPLY_TEMP_CHANNEL, SUPPLY_TEMP_25C_UV / 1000 * SUPPLY_ADC_MAX / SIM_VDD_MV);
+}
+
+static const char *keys = "";
+static uint32_t keyAt = SIM_KEYS_START_MS;
+
+// Play the -K script on the (active low) programming buttons
+static void pressKeys(uint32_t now) {
+  if (!*keys || now < keyAt) return;
+  char k = *keys;
+  uint8_t pin = k == '+' ? AUX2_IN : k == '-' || k == 'T' ? RESET_IN : AUX1_IN;
+  uint32_t hold = k == 'M' || k == 'T' ? MENU_HOLD_MS + SIM_KEY_PRESS_MS : SIM_KEY_PRESS_MS;
+  if (now < keyAt + hold) {
+    simSetPin(pin, LOW);
+    return;
+  }
+  simSetPin(pin, HIGH);
+  keyAt = now + SIM_KEY_GAP_MS;
+  keys++;
+}
+
+static int writeRecord(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) return -1;
+  fprintf(f, "%s\n", RECORD_TEXT_HEADER);
+  RecordEvent e;
+  for (uint32_t i = recordFirst(); recordGet(i, &e); i++) {
+    fprintf(f, "%lu %s %u %u\n", (unsigned long)e.micros, recordTypeName(e.type), e.id, e.value);
+  }
+  return fclose(f);
+}
+
+static int ptyMaster = -1;
+
+static void ptyWrite(const uint8_t *data, size_t len) {
+  while (len) {
+    ssize_t n = write(ptyMaster, data, len);
+    if (n <= 0) return; // nobody reading and the pty buffer is full: drop
+    data += n;
+    len -= n;
+  }
+}
+
+static void ptyRead() {
+  uint8_t buf[256];
+  ssize_t n = read(ptyMaster, buf, sizeof(buf));
+  if (n > 0) simSerialInput(buf, n);
+}
+
+static void makeRaw(int fd) {
+  struct termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
+// A new pty master with its slave held open in raw mode, so clients can come and go
+static int newPty(const char **name) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return -1;
+  *name = ptsname(master);
+  int slave = open(*name, O_RDWR | O_NOCTTY);
+  if (slave < 0) return -1;
+  makeRaw(slave);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  return master;
+}
+
+static int openPty() {
+  const char *name;
+  ptyMaster = newPty(&name);
+  if (ptyMaster < 0) return -1;
+  printf("serial port on %s\n", name);
+  fflush(stdout);
+  return 0;
+}
+
+static void linkWrite(const uint8_t *data, size_t len) {
+  while (len) {
+    ssize_t n = write(linkFd, data, len);
+    if (n <= 0) return; // the other side is not draining it: drop, like a UART with no receiver
+    data += n;
+    len -= n;
+  }
+}
+
+static void linkRead() {
+  uint8_t buf[256];
+  ssize_t n = read(linkFd, buf, sizeof(buf));
+  if (n > 0) simUartInput(buf, n);
+}
+
+static int openLink(const char *port) {
+  const char *name = port;
+  if (strcmp(port, "pty") == 0) {
+    linkFd = newPty(&name);
+  }
+  else {
+    linkFd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (linkFd >= 0) makeRaw(linkFd);
+  }
+  if (linkFd < 0) return -1;
+  printf("link port on %s\n", name);
+  fflush(stdout);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  unsigned coins = 1, limitSec = 600;
+  const char *eepromFile = "hotshot-sim-eeprom.bin";
+  const char *recordFile = 0, *linkPort = 0;
+  uint32_t jamAt = 0, sagAt = 0;
+  bool jammed = false, sagging = false;
+  bool quiet = false, probes = false, pty = false, cyclic = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:s:t:e:L:R:U:J:V:K:CqpPh")) != -1) {
+    switch (opt) {
+      case 'c': coins = atoi(optarg); break;
+      case 's': shotsPerGame = atoi(optarg); break;
+      case 't': limitSec = atoi(optarg); break;
+      case 'e': eepromFile = optarg; break;
+      case 'L': eeprom_sim_set_write_latency(atoi(optarg)); break;
+      case 'R': recordFile = optarg; break;
+      case 'U': linkPort = optarg; break;
+      case 'J': jamAt = atoi(optarg); break;
+      case 'V': sagAt = atoi(optarg); break;
+      case 'K': keys = optarg; break;
+      case 'C': cyclic = true; break;
+      case 'q': quiet = true; break;
+      case 'p': probes = true; break;
+      case 'P': pty = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-c coins] [-s shots] [-t seconds] [-e eeprom-file] [-L write-us] [-R record-file] [-U pty|device] [-J jam-ms] [-V sag-ms] [-K keys] [-C] [-q] [-p] [-P]\n", argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (eeprom_sim_open(eepromFile) != 0) {
+    perror(eepromFile);
+    return 1;
+  }
+
+  simReset();
+  simSerialEcho(!quiet && !pty);
+  if (pty) {
+    if (openPty() != 0) {
+      perror("pty");
+      return 1;
+    }
+    simSerialCapture(ptyWrite);
+  }
+  if (linkPort) {
+    if (openLink(linkPort) != 0) {
+      perror(linkPort);
+      return 1;
+    }
+    simUartCapture(linkWrite);
+  }
+  eeprom_sim_set_latency_hook(delayMicroseconds); // EEPROM writes cost virtual time
+  simOnPinChange(onPinChange);
+
+  // the firmware's boot order (src/main.cpp), less the parts that need the hardware
+  bootMark(BOOT_CORE);
+  setupEEPROM();
+  bootMark(BOOT_CONFIG);
+  setupRecord();
+  bootMark(BOOT_RECORD);
+  setupIO();
+  setupMenu();
+  setSupply(SIM_SUPPLY_MV);
+  bootMark(BOOT_IO);
+  setupTimers();
+  setupDisplay(); // a thread of its own on the cabinet
+  bootMark(BOOT_TIMERS);
+  setupLink();
+  bootMark(BOOT_LINK);
+  setupInterrupts();
+  bootMark(BOOT_IRQ);
+  if (cyclic) {
+    setupStatusLed();
+    setupCyclic();
+  }
+  bootMark(BOOT_READY);
+  setupSupplyMonitor();
+  setupProbes();
+  bootMark(BOOT_PROBES);
+  setupTelemetry("sim");
+  bootMark(BOOT_TELEMETRY);
+  bootReport(Serial);
+
+  struct timespec wallStart, wallEnd;
+  clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+  uint64_t limitUs = (uint64_t)limitSec * 1000000;
+  bool realTime = pty || linkFd >= 0;
+  uint32_t idleSinceMillis = 0;
+  unsigned coinsInserted = 0;
+  while (simMicros() < limitUs) {
+    uint32_t now = millis();
+    if (coinsInserted < coins && now >= COIN_FIRST_MS + coinsInserted * COIN_SPACING_MS) {
+      simSetPin(COIN1_IN, LOW);
+      if (now >= COIN_FIRST_MS + coinsInserted * COIN_SPACING_MS + COIN_PULSE_MS) {
+        simSetPin(COIN1_IN, HIGH); // rising edge on release
+        coinsInserted++;
+      }
+    }
+
+    if (pty) ptyRead();
+    if (linkFd >= 0) linkRead();
+    bool jamNow = jamAt && now >= jamAt && now < jamAt + SIM_JAM_MS;
+    if (jamNow != jammed) {
+      simSetPin(UPPER_OPTO_IN, jamNow ? OPTO_BLOCKED : !OPTO_BLOCKED);
+      jammed = jamNow;
+    }
+    if (!jammed) shoot(now);
+    bool sagNow = sagAt && now >= sagAt && now < sagAt + SIM_SAG_MS;
+    if (sagNow != sagging) {
+      setSupply(sagNow ? SIM_SAG_MV : SIM_SUPPLY_MV);
+      sagging = sagNow;
+    }
+    pressKeys(now);
+
+    if (cyclic) {
+      cyclicPoll();
+    }
+    else {
+      gameUpdate();
+      menuPoll();
+      selfTestPoll();
+      linkPoll();
+      gamePoll();
+      configFlush();
+      telemetryPoll();
+      displayUpdate();
+    }
+
+    if (!pty && coinsInserted == coins && gameIdle() && !*keys && !menuActive() && !selfTestActive()) {
+      if (linkFd < 0) break;
+      if (!idleSinceMillis) idleSinceMillis = now;
+      if (now - idleSinceMillis >= SIM_LINK_LINGER_MS) break;
+    }
+    simAdvance(linkFd >= 0 ? SIM_LINK_STEP_US : SIM_STEP_US);
+
+    if (realTime) {
+      // hold virtual time to wall time
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      uint64_t wallUs = (now.tv_sec - wallStart.tv_sec) * 1000000ULL + (now.tv_nsec - wallStart.tv_nsec) / 1000;
+      if (simMicros() > wallUs) usleep(simMicros() - wallUs);
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+  double wallMs = (wallEnd.tv_sec - wallStart.tv_sec) * 1e3 + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e6;
+  double simMs = simMicros() / 1e3;
+
+  printf("\nsimulated %.1f s in %.1f ms (%.0fx real time)\n", simMs / 1e3, wallMs, wallMs > 0 ? simMs / wallMs : 0);
+  printf("coins %u, games %u, tickets %u, last score %u, credits left %u\n",
+         coinsInserted, gamesStarted, ticketPulses, lastScore, curCredits);
+  ShotSummary shots;
+  shotsSummary(SHOTS_LIFETIME, &shots);
+  printf("baskets %u, swishes %u, transit %.1f-%.1f ms\n", shots.baskets, shots.swishes,
+         shots.minUs / 1e3, shots.maxUs / 1e3);
+  printf("display digit writes %u\n", displayWrites());
+
+  if (cyclic) {
+    CyclicStatus c;
+    CyclicTaskStatus t;
+    cyclicStatus(&c);
+    printf("cyclic: %u frames, %u overruns, longest frame %u us; worst case", c.frames, c.overruns, c.maxFrameUs);
+    for (uint8_t i = 0; cyclicTask(i, &t); i++) printf("%s %s %u us", i ? "," : "", cyclicTaskName(i), t.maxUs);
+    printf("\n");
+  }
+
+  if (recordFile && writeRecord(recordFile) != 0) perror(recordFile);
+
+  if (probes) {
+    simSerialCapture(0);
+    simSerialEcho(true);
+    probe_report(Serial);
+  }
+
+  eeprom_sim_close();
+  return gameIdle() ? 0 : 2;
+}
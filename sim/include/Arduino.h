@@ -0,0 +1,184 @@
+/*
+ * Arduino.h - simulation HAL for host builds.
+ *
+ * Provides the subset of the Teensyduino core API used by src/ and lib/ so
+ * that the game logic and the portable libraries compile natively on Linux.
+ * Time is virtual: millis()/micros() only move when the simulator (or code
+ * under test) calls delay(), delayMicroseconds() or simAdvance(), and pin
+ * interrupts and IntervalTimers are dispatched synchronously from there.
+ * See sim.h for the controls that drive it.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "binary.h"
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define CHANGE 4
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LED_BUILTIN 13
+#define CORE_NUM_DIGITAL 34
+#define CORE_NUM_ANALOG_INPUTS 64 // analogRead() channels, incl. the ADC library's internal sources (38-43)
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define A8 22
+#define A9 23
+#define A10 34
+#define A11 35
+#define A12 36
+#define A13 37
+#define A14 40
+
+#define digitalPinToInterrupt(p) ((p) < CORE_NUM_DIGITAL ? (p) : -1)
+
+#define F_CPU 72000000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+uint8_t digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*function)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t msec);
+void delayMicroseconds(uint32_t usec);
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+void shiftOut_lsbFirst(uint8_t dataPin, uint8_t clockPin, uint8_t value);
+void shiftOut_msbFirst(uint8_t dataPin, uint8_t clockPin, uint8_t value);
+
+int analogRead(uint8_t pin);
+
+void yield(void);
+
+static inline void digitalWriteFast(uint8_t pin, uint8_t val) { digitalWrite(pin, val); }
+static inline uint8_t digitalReadFast(uint8_t pin) { return digitalRead(pin); }
+
+// the simulator is single threaded and dispatches "interrupts" synchronously
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+#define interrupts() __enable_irq()
+#define noInterrupts() __disable_irq()
+
+#ifdef __cplusplus
+} // extern "C"
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+  size_t print(const char s[]) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(uint8_t b, int base = DEC) { return printNumber(b, base, false); }
+  size_t print(int n, int base = DEC) { return printNumber(n, base, true); }
+  size_t print(unsigned int n, int base = DEC) { return printNumber(n, base, false); }
+  size_t print(long n, int base = DEC) { return printNumber(n, base, true); }
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base, false); }
+  size_t print(long long n, int base = DEC) { return printNumber(n, base, true); }
+  size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base, false); }
+  size_t print(double n, int digits = 2);
+
+  size_t println() { return write((const uint8_t *)"\r\n", 2); }
+  template <typename T> size_t println(T arg) { size_t n = print(arg); return n + println(); }
+  template <typename T> size_t println(T arg, int fmt) { size_t n = print(arg, fmt); return n + println(); }
+
+  int printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+private:
+  size_t printNumber(unsigned long long n, int base, bool sign);
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(char *buffer, size_t length);
+};
+
+/*
+ * USB serial. Output goes to stdout when echo is enabled (see simSerialEcho),
+ * input is whatever the simulator queued with simSerialInput().
+ */
+class usb_serial_class : public Stream {
+public:
+  void begin(long) {}
+  void end() {}
+  int available();
+  int read();
+  int peek();
+  void flush() {}
+  int availableForWrite() { return 512; } // Teensy 3 queues up to 8 64-byte packets
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+  operator bool() { return true; }
+};
+
+extern usb_serial_class Serial;
+
+// The hardware UARTs: Serial1 only, fed and drained through sim.h
+class HardwareSerial : public Stream {
+public:
+  void begin(uint32_t) {}
+  void end() {}
+  int available();
+  int read();
+  int peek();
+  void flush() {}
+  int availableForWrite() { return 64; } // the core's default transmit buffer
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+  operator bool() { return true; }
+};
+
+extern HardwareSerial Serial1;
+
+#include "IntervalTimer.h"
+
+#endif // __cplusplus
+
+#endif
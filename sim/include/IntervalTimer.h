@@ -0,0 +1,35 @@
+/*
+ * IntervalTimer.h - simulation HAL replacement for the Teensy PIT timers.
+ *
+ * Callbacks fire from simAdvance() at their exact virtual deadlines. Like
+ * the hardware, only four timers can run at once.
+ */
+
+#ifndef __INTERVALTIMER_H__
+#define __INTERVALTIMER_H__
+
+#include <stdint.h>
+
+class IntervalTimer {
+public:
+  static const int NUM_TIMERS = 4;
+
+  IntervalTimer() : slot(-1), nvic_priority(128) {}
+  ~IntervalTimer() { end(); }
+
+  bool begin(void (*funct)(), unsigned int microseconds);
+  bool begin(void (*funct)(), int microseconds) { return begin(funct, (unsigned int)microseconds); }
+  bool begin(void (*funct)(), unsigned long microseconds) { return begin(funct, (unsigned int)microseconds); }
+  bool begin(void (*funct)(), long microseconds) { return begin(funct, (unsigned int)microseconds); }
+  bool begin(void (*funct)(), float microseconds) { return begin(funct, (unsigned int)microseconds); }
+  bool begin(void (*funct)(), double microseconds) { return begin(funct, (unsigned int)microseconds); }
+  void update(unsigned int microseconds);
+  void end();
+  void priority(uint8_t n) { nvic_priority = n; }
+
+private:
+  int slot;
+  uint8_t nvic_priority;
+};
+
+#endif
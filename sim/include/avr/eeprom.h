@@ -0,0 +1,98 @@
+/*
+ * avr/eeprom.h - host replacement for the Teensy 3.x EEPROM API.
+ *
+ * Declares the same eeprom_* functions the Teensy core provides so that
+ * lib/EEPROM and any code built on top of it compiles unchanged on Linux.
+ * The implementation (sim/eeprom_sim.cpp) keeps the EEPROM contents in a
+ * memory-mapped backing file, counts committed writes per cell and can
+ * model the FlexRAM write latency of the real part.
+ *
+ * The eeprom_sim_* functions are host-only extensions used by the
+ * simulator, benchmarks and the eeprom-wear tool.
+ */
+
+#ifndef _AVR_EEPROM_H_
+#define _AVR_EEPROM_H_ 1
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Teensy 3.1/3.2 (MK20DX256) has 2048 bytes of emulated EEPROM
+#ifndef E2END
+#define E2END 0x7FF
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void eeprom_initialize(void);
+uint8_t eeprom_read_byte(const uint8_t *addr);
+uint16_t eeprom_read_word(const uint16_t *addr);
+uint32_t eeprom_read_dword(const uint32_t *addr);
+void eeprom_read_block(void *buf, const void *addr, uint32_t len);
+void eeprom_write_byte(uint8_t *addr, uint8_t value);
+void eeprom_write_word(uint16_t *addr, uint16_t value);
+void eeprom_write_dword(uint32_t *addr, uint32_t value);
+void eeprom_write_block(const void *buf, void *addr, uint32_t len);
+int eeprom_is_ready(void);
+#define eeprom_busy_wait() do {} while (!eeprom_is_ready())
+
+static inline void eeprom_update_byte(uint8_t *addr, uint8_t value)
+{
+  eeprom_write_byte(addr, value);
+}
+static inline void eeprom_update_word(uint16_t *addr, uint16_t value)
+{
+  eeprom_write_word(addr, value);
+}
+static inline void eeprom_update_dword(uint32_t *addr, uint32_t value)
+{
+  eeprom_write_dword(addr, value);
+}
+static inline void eeprom_update_block(const void *buf, void *addr, uint32_t len)
+{
+  eeprom_write_block(buf, addr, len);
+}
+
+/*
+ * Host-only extensions
+ * ==========================================================================================
+ */
+
+// Map 'path' as the EEPROM backing file, creating it (erased to 0xFF) if it
+// does not exist. Any previously opened file is closed first. Returns 0 on
+// success, -1 on failure. If never called, eeprom_initialize() opens the file
+// named by $HOTSHOT_EEPROM_FILE, or "hotshot-eeprom.bin".
+int eeprom_sim_open(const char *path);
+// Flush and unmap the backing file.
+void eeprom_sim_close(void);
+
+// Time spent blocked by every committed (changed) byte write, in microseconds.
+// The real FlexRAM takes roughly 0.1 - 1.5 ms per write depending on whether
+// the EEE state machine has to copy a sector. Default is 0 (no delay).
+void eeprom_sim_set_write_latency(uint32_t microseconds);
+// Replace how the latency is spent. The default sleeps the calling thread;
+// the simulator installs a hook that advances its virtual clock instead.
+void eeprom_sim_set_latency_hook(void (*hook)(uint32_t microseconds));
+
+// Committed writes to a single cell since the backing file was created
+uint32_t eeprom_sim_write_count(uint32_t addr);
+// Total committed byte writes, and writes skipped because the value was unchanged
+uint64_t eeprom_sim_total_writes(void);
+uint64_t eeprom_sim_skipped_writes(void);
+// Accumulated modeled latency in microseconds
+uint64_t eeprom_sim_total_latency(void);
+// Zero all wear counters (the stored data is kept)
+void eeprom_sim_reset_wear(void);
+
+// Print the 'top' most-written cells, with projected lifetime against
+// 'endurance' writes per cell, given that the counts were collected over
+// 'simulated_days' of operation (pass 0 to omit the projection).
+void eeprom_sim_report(FILE *out, unsigned top, uint32_t endurance, double simulated_days);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
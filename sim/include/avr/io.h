@@ -0,0 +1,12 @@
+/*
+ * avr/io.h - host replacement for the Teensy core's AVR compatibility header.
+ *
+ * lib/EEPROM only needs E2END from here, which avr/eeprom.h provides.
+ */
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <avr/eeprom.h>
+
+#endif
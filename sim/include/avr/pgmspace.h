@@ -0,0 +1,20 @@
+/*
+ * avr/pgmspace.h - host replacement; flash and RAM share one address space.
+ */
+
+#ifndef __PGMSPACE_H_
+#define __PGMSPACE_H_ 1
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(str) (str)
+#define F(str) (str)
+
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#define pgm_read_dword(addr) (*(const unsigned long *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * sim.h - controls for the host simulation HAL (sim/include/Arduino.h).
+ *
+ * A simulation owns a virtual microsecond clock. Nothing runs on its own:
+ * the driver advances time, injects input edges and observes outputs, and
+ * pin interrupts and IntervalTimer callbacks run synchronously as that
+ * happens, in the order their virtual timestamps dictate.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Clear pins, interrupts, timers, serial buffers and set the clock to zero
+void simReset();
+
+// Virtual time since simReset()
+uint64_t simMicros();
+
+// Move the clock forward, firing every IntervalTimer that comes due on the way
+void simAdvance(uint32_t microseconds);
+// Advance to an absolute time (no-op if already past it)
+void simAdvanceTo(uint64_t microseconds);
+
+// Drive an input pin from the outside world. If the level changes and an
+// interrupt is attached with a matching mode, its handler runs immediately.
+void simSetPin(uint8_t pin, uint8_t level);
+// Current level of any pin, as driven by firmware or simSetPin()
+uint8_t simGetPin(uint8_t pin);
+// Called after every output level change made by the firmware
+void simOnPinChange(void (*callback)(uint8_t pin, uint8_t level));
+
+// Echo Serial output to stdout (default on)
+void simSerialEcho(bool enable);
+// Queue bytes for Serial.read()
+void simSerialInput(const uint8_t *data, size_t len);
+// Receive Serial output (in addition to any echo); pass 0 to remove
+void simSerialCapture(void (*callback)(const uint8_t *data, size_t len));
+
+// Queue bytes for Serial1.read()
+void simUartInput(const uint8_t *data, size_t len);
+// Receive Serial1 output; pass 0 to remove (output is dropped otherwise)
+void simUartCapture(void (*callback)(const uint8_t *data, size_t len));
+
+// Value analogRead() returns for a pin or internal channel (default 0)
+void simSetAnalog(uint8_t pin, int value);
+
+#endif
@@ -0,0 +1,137 @@
+#include <Arduino.h>
+
+// Only benchmark builds carry the benchmarks: their registrations are static constructors,
+// which would otherwise keep all of this in every firmware image
+#if defined(HOTSHOT_BENCH) || defined(HOTSHOT_SIM)
+
+#include <Bench.h>
+#include <BlockPool.h>
+#include <CobsFrame.h>
+#include <Mailbox.h>
+#include <RingBuffer.h>
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#endif
+
+#include "benchmarks.h"
+#include "config.h"
+#include "display.h"
+#include "game.h"
+#include "menu.h"
+#include "timebase.h"
+
+
+#if defined(__arm__)
+static int yielder = -1;
+
+static void yieldLoop() {
+  while (1) threads.yield();
+}
+
+BENCH(schedulerSwitch, "scheduler switch") {
+  threads.restart(yielder);
+  for (uint32_t i = 0; i < iterations; i++) threads.yield();
+  threads.suspend(yielder);
+}
+#endif
+
+BENCH(ringPushPop, "ring buffer push/pop") {
+  static RingBuffer ring;
+  for (uint32_t i = 0; i < iterations; i++) {
+    ring.write(i);
+    bench_keep(ring.read());
+  }
+}
+
+BLOCK_POOL(benchPool, "bench", 16, 2);
+
+BENCH(poolAllocFree, "block pool alloc/free") {
+  for (uint32_t i = 0; i < iterations; i++) {
+    void *p = benchPool.alloc();
+    bench_keep((uintptr_t)p);
+    benchPool.free(p);
+  }
+}
+
+MAILBOX(benchBox, "bench", 2);
+
+BENCH(mailboxPostReceive, "mailbox post/receive") {
+  static uint32_t msg;
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchBox.post(&msg);
+    bench_keep((uintptr_t)benchBox.tryReceive());
+  }
+}
+
+static uint8_t payload[BENCH_FRAME_BYTES];
+static uint8_t frame[COBS_FRAME_MAX(BENCH_FRAME_BYTES)];
+static size_t frameLen;
+
+BENCH(frameEncode, "frame encode") {
+  for (uint32_t i = 0; i < iterations; i++) {
+    payload[0] = i; // a different frame every time
+    frameLen = cobs_frame_encode(payload, sizeof(payload), frame, sizeof(frame));
+    bench_keep(frameLen);
+  }
+}
+
+BENCH(frameDecode, "frame decode") {
+  static uint8_t buf[COBS_FRAME_MAX(BENCH_FRAME_BYTES)];
+  CobsFrameDecoder decoder(buf, sizeof(buf));
+  if (!frameLen) frameLen = cobs_frame_encode(payload, sizeof(payload), frame, sizeof(frame));
+  for (uint32_t i = 0; i < iterations; i++) {
+    int len = 0;
+    for (size_t j = 0; j < frameLen; j++) len = decoder.push(frame[j]);
+    bench_keep(len);
+  }
+}
+
+BENCH(buttonCheck, "button check") {
+  for (uint32_t i = 0; i < iterations; i++) menuPoll();
+}
+
+BENCH(displayFrame, "display frame") {
+  uint8_t score = lastScore;
+  for (uint32_t i = 0; i < iterations; i++) {
+    lastScore = i & 1 ? 88 : 11; // the attract screen shows it; both digits change
+    displayUpdate();
+  }
+  lastScore = score;
+  displayUpdate();
+}
+
+#if defined(HOTSHOT_SIM)
+BENCH(configFlushOne, "eeprom config flush") {
+  uint8_t value = configGet(CFG_ATTRACT_TIME);
+  for (uint32_t i = 0; i < iterations; i++) {
+    configApply(CFG_ATTRACT_TIME, value ^ (i & 1)); // a new value every time
+    while (configFlush());
+  }
+  configApply(CFG_ATTRACT_TIME, value);
+  while (configFlush());
+}
+#endif
+
+BENCH(gameUpdateAttract, "game update") {
+  for (uint32_t i = 0; i < iterations; i++) gameUpdate();
+}
+
+BENCH(timeBase, "time base") {
+  for (uint32_t i = 0; i < iterations; i++) bench_keep((uint32_t)timeMicros());
+}
+
+void setupBench() {
+  setupEEPROM();
+  setupIO();
+  setupMenu();
+  setupDisplay();
+#if defined(__arm__)
+  yielder = threads.addThread(yieldLoop);
+  threads.setName(yielder, "bench yield");
+  threads.suspend(yielder); // only runs during the scheduler switch benchmark
+#endif
+  bench_init();
+}
+
+#endif // HOTSHOT_BENCH || HOTSHOT_SIM
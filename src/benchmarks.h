@@ -0,0 +1,58 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdint.h>
+
+
+/* BENCHMARKS
+ * ==========================================================================================
+ * The firmware's hot paths as microbenchmarks (lib/Bench), run by the same code on the host
+ * (hotshot-bench, sim/hotshot_bench.cpp) and on the cabinet: a firmware built with
+ * HOTSHOT_BENCH runs them instead of the game and prints the JSON report once the USB
+ * host opens the port.
+ *
+ * Benchmark              One iteration
+ * ------------------------------------------------------------------------------------------
+ * scheduler switch       threads.yield() to a second thread and back: two context switches
+ *                        (cabinet only; the host has no threads)
+ * ring buffer push/pop   a RingBuffer (lib/ADC) write and read
+ * block pool alloc/free  a BlockPool create and destroy
+ * mailbox post/receive   a Mailbox post and tryReceive
+ * frame encode           a BENCH_FRAME_BYTES telemetry payload through cobs_frame_encode()
+ * frame decode           the same frame through a CobsFrameDecoder, byte by byte
+ * button check           menuPoll(): the three programming buttons' AceButton checks
+ * display frame          displayUpdate() with a new score: render, diff and two digit
+ *                        writes to the MAX7219s
+ * eeprom config flush    configApply() and configFlush() of one setting: two EEPROM
+ *                        updates (host only; on the cabinet it would wear the part)
+ * game update            gameUpdate() in attract mode
+ * time base              timeMicros()
+ *
+ * Only the minimum of each benchmark is compared. The baseline in the tree,
+ * sim/bench_baseline.json, stores each minimum as a ratio to the geometric mean of the run,
+ * so that it holds on any host; after changing a hot path:
+ *
+ *   hotshot-bench -b sim/bench_baseline.json    check: fails on a slowdown over 50% relative
+ *                                               to the other benchmarks
+ *   hotshot-bench -B sim/bench_baseline.json    accept the new figures; commit the file with
+ *                                               the change that moved them
+ *
+ * A cabinet report (a HOTSHOT_BENCH firmware's output saved from the USB serial port) is
+ * checked with -c report.json -b, against the same file or a cabinet baseline made with
+ * -c report.json -B. For a finer check, compare in ns with a report taken before the change
+ * on the same machine (-o, then -b); see sim/hotshot_bench.cpp.
+ */
+
+#if defined(__arm__)
+#define BENCH_PLATFORM "teensy32"
+#else
+#define BENCH_PLATFORM "host"
+#endif
+#define BENCH_FRAME_BYTES 32
+
+// Set up what the benchmarks use (settings, pins, buttons, displays, the yield partner
+// thread) in place of the normal boot
+void setupBench();
+
+
+#endif // BENCHMARKS_H
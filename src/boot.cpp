@@ -0,0 +1,43 @@
+#include <Arduino.h>
+
+#include "boot.h"
+#include "timebase.h"
+
+
+static uint32_t phaseMicros[BOOT_PHASE_COUNT];
+static uint16_t phasesRun; // bit per phase
+
+static const char * const phaseNames[BOOT_PHASE_COUNT] = BOOT_PHASE_NAMES;
+
+
+void bootMark(uint8_t phase) {
+  if (phase >= BOOT_PHASE_COUNT) return;
+  phaseMicros[phase] = (uint32_t)timeMicros();
+  phasesRun |= 1 << phase;
+}
+
+bool bootReached(uint8_t phase) {
+  return phase < BOOT_PHASE_COUNT && (phasesRun & (1 << phase));
+}
+
+uint16_t bootPhasesRun() {
+  return phasesRun;
+}
+
+uint32_t bootMicros(uint8_t phase) {
+  return bootReached(phase) ? phaseMicros[phase] : 0;
+}
+
+const char *bootPhaseName(uint8_t phase) {
+  return phase < BOOT_PHASE_COUNT ? phaseNames[phase] : "?";
+}
+
+void bootReport(Print &out) {
+  uint32_t last = 0;
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (!bootReached(i)) continue;
+    out.printf("boot %-10s %8lu us  (+%lu us)\r\n", phaseNames[i], (unsigned long)phaseMicros[i],
+               (unsigned long)(phaseMicros[i] - last));
+    last = phaseMicros[i];
+  }
+}
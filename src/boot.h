@@ -0,0 +1,51 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+
+/* BOOT TIMING
+ * ==========================================================================================
+ * setup() marks the end of each startup phase with timeMicros() (timebase.h), which counts from the core's
+ * reset handler, so every mark is the time since power-on (less the clock setup before the
+ * SysTick starts). BOOT_CORE is setup() being entered: everything the core does first,
+ * including its USB start-up delays.
+ *
+ * The cabinet accepts coins and runs games from BOOT_READY; the target is under 50 ms.
+ * Phases after it (probes, memory map, telemetry) no longer hold the game back. USB
+ * enumeration does not gate anything, so the report is read later with hsctl boot.
+ */
+
+enum BootPhase {
+  BOOT_CORE,
+  BOOT_CRASH,
+  BOOT_CONFIG,
+  BOOT_RECORD,
+  BOOT_IO,
+  BOOT_TIMERS,
+  BOOT_LINK,
+  BOOT_IRQ,        // interrupt priorities (irq.h)
+  BOOT_READY,      // game threads running
+  BOOT_PROBES,
+  BOOT_MEMORY,
+  BOOT_TELEMETRY,
+  BOOT_PHASE_COUNT
+};
+
+#define BOOT_PHASE_NAMES { "core", "crash", "config", "record", "io", "timers", "link", \
+                           "irq", "ready", "probes", "memory", "telemetry" }
+
+// Record that 'phase' has finished now
+void bootMark(uint8_t phase);
+bool bootReached(uint8_t phase);
+uint16_t bootPhasesRun(); // bit per phase that has run
+// timeMicros() when 'phase' finished; 0 if it has not run
+uint32_t bootMicros(uint8_t phase);
+const char *bootPhaseName(uint8_t phase);
+
+class Print;
+// One line per phase that ran: its end time and how long it took
+void bootReport(Print &out);
+
+
+#endif // BOOT_H
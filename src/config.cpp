@@ -0,0 +1,119 @@
+#include <Arduino.h>
+
+#include <EEPROM.h>
+#include <CobsFrame.h>
+
+#include "config.h"
+#include "record.h"
+
+
+uint8_t highScore, ticketsPerScore, playsPerCredit, playTime, attractTime;
+// uint16_t jackpotTickets;
+
+static uint8_t * const configVars[CFG_COUNT] = {
+  &highScore, &ticketsPerScore, &playsPerCredit, &playTime, &attractTime
+};
+
+// changed in RAM but not yet in the EEPROM; the menu, telemetry and loop() threads share these
+static volatile uint8_t pending; // bit per setting
+static volatile bool crcPending;
+static volatile bool flushing;   // a thread is writing the EEPROM
+
+static const uint8_t configDefaults[CFG_COUNT] = {
+  HIGH_SCORE_DEFAULT, TICKETS_PER_SCORE_DEFAULT, PLAYS_PER_CREDIT_DEFAULT, PLAY_TIME_DEFAULT, ATTRACT_TIME_DEFAULT
+};
+
+static bool configValid(uint8_t field, uint8_t value) {
+  return value != 0 || field == CFG_HIGH_SCORE; // a zero play/attract time or rate is never valid
+}
+
+static uint16_t configCrc() {
+  uint8_t values[CFG_COUNT];
+  for (uint8_t i = 0; i < CFG_COUNT; i++) values[i] = *configVars[i];
+  return cobs_crc16(values, CFG_COUNT);
+}
+
+static void storeCrc() {
+  uint16_t crc = configCrc();
+  EEPROM.update(CONFIG_CRC_EEPROMADDR, crc & 0xFF);
+  EEPROM.update(CONFIG_CRC_EEPROMADDR + 1, crc >> 8);
+}
+
+void setupEEPROM() {
+  bool valid = true;
+  for (uint8_t i = 0; i < CFG_COUNT; i++) {
+    *configVars[i] = EEPROM.read(HIGH_SCORE_EEPROMADDR + i);
+    valid = valid && configValid(i, *configVars[i]);
+  }
+  uint16_t crc = EEPROM.read(CONFIG_CRC_EEPROMADDR) | (EEPROM.read(CONFIG_CRC_EEPROMADDR + 1) << 8);
+
+  // never programmed, from an older firmware, or corrupt
+  if (!valid || crc != configCrc()) {
+    for (uint8_t i = 0; i < CFG_COUNT; i++) {
+      *configVars[i] = configDefaults[i];
+      EEPROM.update(HIGH_SCORE_EEPROMADDR + i, configDefaults[i]);
+    }
+    storeCrc();
+    Serial.println("EEPROM settings invalid, defaults stored");
+  }
+
+  Serial.print("Play Time: ");
+  Serial.println(playTime);
+}
+
+uint8_t configGet(uint8_t field) {
+  return field < CFG_COUNT ? *configVars[field] : 0;
+}
+
+bool configSet(uint8_t field, uint8_t value) {
+  if (!configApply(field, value)) return false;
+  while (configFlush());
+  return true;
+}
+
+bool configApply(uint8_t field, uint8_t value) {
+  if (field >= CFG_COUNT) return false;
+  if (!configValid(field, value)) return false;
+
+  __disable_irq();
+  *configVars[field] = value;
+  if (!replayMode()) {
+    pending |= 1 << field;
+    crcPending = true;
+  }
+  __enable_irq();
+  recordEvent(REC_CONFIG, field, value);
+  return true;
+}
+
+uint8_t configReload() {
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < CFG_COUNT; i++) {
+    uint8_t value = EEPROM.read(HIGH_SCORE_EEPROMADDR + i);
+    if (value != *configVars[i]) changed |= 1 << i;
+    *configVars[i] = value;
+  }
+  return changed;
+}
+
+bool configFlush() {
+  __disable_irq();
+  if (flushing) {
+    __enable_irq();
+    return true; // another thread is at it
+  }
+  uint8_t field = CFG_COUNT;
+  for (uint8_t i = 0; i < CFG_COUNT && field == CFG_COUNT; i++) {
+    if (pending & (1 << i)) field = i;
+  }
+  bool crc = field == CFG_COUNT && crcPending;
+  if (field < CFG_COUNT) pending &= ~(1 << field);
+  if (crc) crcPending = false;
+  flushing = field < CFG_COUNT || crc;
+  __enable_irq();
+
+  if (field < CFG_COUNT) EEPROM.update(HIGH_SCORE_EEPROMADDR + field, *configVars[field]);
+  else if (crc) storeCrc(); // a settings change is whole only once this is written
+  flushing = false;
+  return pending || crcPending;
+}
@@ -0,0 +1,71 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+
+
+/* CONSTANTS (store in EEPROM for programmability, todo later)
+ * ====================================================================================================
+ * Variable Name      Type       Default    Description
+ * ====================================================================================================
+ * highScore          uint8_t     15        highest number of balls scored in previous games (saved to eeprom on every change)
+ * ticketsPerScore    uint8_t     1         number of tickets earned per ball scored
+ * playsPerCredit     uint8_t     1         number of plays per credit
+ * // jackpotTickets  uint16_t    0         number of tickets earned when high score is beat (maybe just a multiplier of the high-score?)
+ * playTime           uint8_t     60        time in seconds each game lasts
+ * attractTime        uint8_t     240       time in seconds between attract-activations
+ */
+
+#define HIGH_SCORE_DEFAULT 15
+#define TICKETS_PER_SCORE_DEFAULT 4
+#define PLAYS_PER_CREDIT_DEFAULT 1
+#define PLAY_TIME_DEFAULT 5
+#define ATTRACT_TIME_DEFAULT 240
+
+#define HIGH_SCORE_EEPROMADDR 128
+#define TICKETS_PER_SCORE_EEPROMADDR 129
+#define PLAYS_PER_CREDIT_EEPROMADDR 130
+#define PLAY_TIME_EEPROMADDR 131
+#define ATTRACT_TIME_EEPROMADDR 132
+#define CONFIG_CRC_EEPROMADDR 133 // CRC-16 of the five settings above, low byte first
+
+extern uint8_t highScore, ticketsPerScore, playsPerCredit, playTime, attractTime;
+// extern uint16_t jackpotTickets;
+
+// Programmable settings by index, in EEPROM address order
+enum ConfigField {
+  CFG_HIGH_SCORE,
+  CFG_TICKETS_PER_SCORE,
+  CFG_PLAYS_PER_CREDIT,
+  CFG_PLAY_TIME,
+  CFG_ATTRACT_TIME,
+  CFG_COUNT
+};
+
+/*
+ * Load the settings. They are used as stored when their CRC matches and every value is
+ * valid; otherwise the defaults are written once. A normal boot only reads the EEPROM.
+ */
+void setupEEPROM();
+
+uint8_t configGet(uint8_t field);
+// Update a setting in RAM and EEPROM; false if the field or value is invalid
+bool configSet(uint8_t field, uint8_t value);
+
+/*
+ * Update a setting in RAM only and queue it for the EEPROM, for callers that must not wait
+ * for a write (the operator menu). configFlush() writes one queued setting per call, then
+ * the CRC once the queue is empty; it returns true while work remains. loop() calls it.
+ */
+bool configApply(uint8_t field, uint8_t value);
+bool configFlush();
+
+/*
+ * In replay mode (record.h) a change stays in RAM: nothing is queued, so a replayed record
+ * never rewrites the cabinet's settings. configReload() reads the stored settings back when
+ * the replay ends and returns a bit per setting that differed.
+ */
+uint8_t configReload();
+
+
+#endif // CONFIG_H
@@ -0,0 +1,231 @@
+#include <Arduino.h>
+#include <stddef.h>
+
+#include "crash.h"
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#endif
+
+
+#define CRASH_MAGIC 0x48534352 // "HSCR"
+
+// MK20DX256 SRAM; a stack pointer outside it is not followed
+#define CRASH_RAM_START 0x1FFF8000
+#define CRASH_RAM_END 0x20008000
+
+// System control block registers not all cores' kinetis.h name
+#define CRASH_SHCSR (*(volatile uint32_t *)0xE000ED24)
+#define CRASH_CFSR (*(volatile uint32_t *)0xE000ED28)
+#define CRASH_HFSR (*(volatile uint32_t *)0xE000ED2C)
+#define CRASH_MMFAR (*(volatile uint32_t *)0xE000ED34)
+#define CRASH_BFAR (*(volatile uint32_t *)0xE000ED38)
+#define CRASH_AIRCR (*(volatile uint32_t *)0xE000ED0C)
+#define CRASH_SHCSR_FAULTS (7 << 16) // MEMFAULTENA | BUSFAULTENA | USGFAULTENA
+
+typedef struct {
+  uint32_t magic;
+  uint32_t reason;
+  uint32_t uptime;     // millis()
+  int32_t thread;      // running TeensyThreads id
+  uint32_t excReturn;  // EXC_RETURN (LR on exception entry)
+  uint32_t sp;         // address of the exception frame
+  uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;
+  uint32_t cfsr, hfsr, mmfar, bfar;
+  struct {
+    uint32_t state, sp, stack, size;
+  } threads[CRASH_THREADS];
+  uint32_t stackWords;
+  uint32_t stack[CRASH_STACK_WORDS]; // from sp upwards
+  uint32_t check;
+} CrashRecord;
+
+#if defined(__arm__)
+// "@" comments out the section flags gcc appends, keeping the section NOBITS
+#define CRASH_NOINIT __attribute__((section(".noinit,\"aw\",%nobits@")))
+#else
+#define CRASH_NOINIT
+#endif
+
+static CrashRecord record CRASH_NOINIT;
+
+static const char * const reasonNames[] = {
+  "none", "hard fault", "memory management fault", "bus fault", "usage fault", "stack overflow"
+};
+
+
+static uint32_t checksum(const CrashRecord *r) {
+  const uint32_t *w = (const uint32_t *)r;
+  uint32_t sum = 0;
+  for (unsigned i = 0; i < offsetof(CrashRecord, check) / 4; i++) {
+    sum = ((sum << 5) | (sum >> 27)) ^ w[i];
+  }
+  return sum;
+}
+
+bool crashPresent() {
+  return record.magic == CRASH_MAGIC && record.check == checksum(&record);
+}
+
+void crashClear() {
+  record.magic = 0;
+}
+
+#if defined(__arm__)
+
+extern "C" void *currentSP; // TeensyThreads: SP of the thread being switched out
+
+static void __attribute__((noreturn)) capture(const uint32_t *frame, uint32_t excReturn, uint32_t reason, int thread) {
+  __disable_irq();
+
+  record.magic = 0;
+  record.reason = reason;
+  record.uptime = millis();
+  record.thread = thread;
+  record.excReturn = excReturn;
+  record.sp = (uint32_t)frame;
+  record.cfsr = CRASH_CFSR;
+  record.hfsr = CRASH_HFSR;
+  record.mmfar = CRASH_MMFAR;
+  record.bfar = CRASH_BFAR;
+
+  for (int i = 0; i < CRASH_THREADS; i++) {
+    void *sp = 0;
+    uint8_t *stack = 0;
+    int size = 0;
+    record.threads[i].state = threads.getStackInfo(i, &sp, &stack, &size);
+    record.threads[i].sp = (uint32_t)sp;
+    record.threads[i].stack = (uint32_t)stack;
+    record.threads[i].size = size;
+  }
+
+  // the hardware-stacked frame and what lies above it, if the SP is sane
+  uint32_t addr = (uint32_t)frame;
+  uint32_t words = 0;
+  if ((addr & 3) == 0 && addr >= CRASH_RAM_START && addr < CRASH_RAM_END) {
+    words = (CRASH_RAM_END - addr) / 4;
+    if (words > CRASH_STACK_WORDS) words = CRASH_STACK_WORDS;
+  }
+  record.stackWords = words;
+  for (uint32_t i = 0; i < words; i++) record.stack[i] = frame[i];
+
+  if (words >= 8) {
+    record.r0 = frame[0];
+    record.r1 = frame[1];
+    record.r2 = frame[2];
+    record.r3 = frame[3];
+    record.r12 = frame[4];
+    record.lr = frame[5];
+    record.pc = frame[6];
+    record.xpsr = frame[7];
+  }
+
+  record.magic = CRASH_MAGIC;
+  record.check = checksum(&record);
+
+  CRASH_AIRCR = 0x05FA0004; // SYSRESETREQ
+  while (1);
+}
+
+extern "C" void __attribute__((used, noreturn)) crash_capture_fault(const uint32_t *frame, uint32_t excReturn, uint32_t reason) {
+  // Threads::id() re-enables interrupts, so ask before capture() masks them
+  capture(frame, excReturn, reason, threads.id());
+}
+
+// Pass the active stack (MSP or PSP, per EXC_RETURN bit 2), EXC_RETURN and the reason
+// to the capture. Naked functions may only hold basic asm, hence the literal reason.
+#define CRASH_FAULT_HANDLER(name, num, reason)               \
+  static_assert(num == reason, #name " reason");             \
+  extern "C" void __attribute__((naked)) name(void) {        \
+    __asm volatile("tst lr, #4        \n"                    \
+                   "ite eq            \n"                    \
+                   "mrseq r0, msp     \n"                    \
+                   "mrsne r0, psp     \n"                    \
+                   "mov r1, lr        \n"                    \
+                   "mov r2, #" #num "\n"                      \
+                   "b crash_capture_fault \n");              \
+  }
+
+CRASH_FAULT_HANDLER(hard_fault_isr, 1, CRASH_HARD_FAULT)
+CRASH_FAULT_HANDLER(memmanage_fault_isr, 2, CRASH_MEM_FAULT)
+CRASH_FAULT_HANDLER(bus_fault_isr, 3, CRASH_BUS_FAULT)
+CRASH_FAULT_HANDLER(usage_fault_isr, 4, CRASH_USAGE_FAULT)
+
+// Called by the scheduler when the outgoing thread's SP is within 8 bytes of its stack base
+extern "C" void stack_overflow_isr(void) {
+  capture((const uint32_t *)currentSP, 0, CRASH_STACK_OVERFLOW, threads.id());
+}
+
+void setupCrash() {
+  // report faults through their own handlers instead of escalating to HardFault
+  CRASH_SHCSR |= CRASH_SHCSR_FAULTS;
+
+  if (crashPresent()) {
+    crashReport(Serial);
+  }
+}
+
+#else
+
+void setupCrash() {}
+
+#endif // __arm__
+
+// 'label' then the word as 0x and eight hex digits. The report is built from print() alone,
+// since printf needs more stack than the telemetry thread (hsctl crash) has to spare.
+static void printWord(Print &out, const char *label, uint32_t v) {
+  char hex[11] = "0x";
+  for (int i = 0; i < 8; i++) hex[2 + i] = "0123456789abcdef"[(v >> (28 - 4 * i)) & 0xF];
+  hex[10] = 0;
+  out.print(label);
+  out.print(hex);
+}
+
+void crashReport(Print &out) {
+  if (!crashPresent()) return;
+
+  const CrashRecord &r = record;
+  out.print("*** CRASH: ");
+  out.print(r.reason < sizeof(reasonNames) / sizeof(reasonNames[0]) ? reasonNames[r.reason] : "?");
+  out.print(" in thread ");
+  out.print((long)r.thread);
+  out.print(" at ");
+  out.print((unsigned long)r.uptime);
+  out.print(" ms\r\n");
+  printWord(out, "  pc  ", r.pc);
+  printWord(out, "  lr  ", r.lr);
+  printWord(out, "  xpsr ", r.xpsr);
+  printWord(out, "  sp ", r.sp);
+  printWord(out, "  exc_return ", r.excReturn);
+  out.print("\r\n");
+  printWord(out, "  r0  ", r.r0);
+  printWord(out, "  r1  ", r.r1);
+  printWord(out, "  r2  ", r.r2);
+  printWord(out, "  r3  ", r.r3);
+  printWord(out, "  r12 ", r.r12);
+  out.print("\r\n");
+  printWord(out, "  cfsr ", r.cfsr);
+  printWord(out, "  hfsr ", r.hfsr);
+  printWord(out, "  mmfar ", r.mmfar);
+  printWord(out, "  bfar ", r.bfar);
+  out.print("\r\n");
+  for (int i = 0; i < CRASH_THREADS; i++) {
+    if (!r.threads[i].state) continue;
+    out.print("  thread ");
+    out.print(i);
+    out.print("  state ");
+    out.print((unsigned long)r.threads[i].state);
+    printWord(out, "  sp ", r.threads[i].sp);
+    printWord(out, "  stack ", r.threads[i].stack);
+    out.print("  size ");
+    out.print((unsigned long)r.threads[i].size);
+    out.print("\r\n");
+  }
+  for (uint32_t i = 0; i < r.stackWords && i < CRASH_STACK_WORDS; i += 4) {
+    printWord(out, "  stack ", r.sp + i * 4);
+    out.print(":");
+    for (uint32_t j = i; j < i + 4 && j < r.stackWords; j++) printWord(out, " ", r.stack[j]);
+    out.print("\r\n");
+  }
+  out.print("*** END CRASH\r\n");
+}
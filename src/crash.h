@@ -0,0 +1,47 @@
+#ifndef CRASH_H
+#define CRASH_H
+
+#include <stdint.h>
+
+
+/* CRASH DUMPS
+ * ==========================================================================================
+ * The HardFault/MemManage/BusFault/UsageFault handlers and TeensyThreads' stack_overflow_isr
+ * are replaced by a capture routine. It stores the exception frame, the fault status
+ * registers, the running thread, every thread's saved SP and the top of the faulting stack
+ * in a .noinit RAM record, then resets the board. The record survives the reset. The next
+ * boot prints it on Serial, and hsctl crash prints it again later.
+ *
+ * tools/symbolize.py turns the addresses in a report into functions and source lines,
+ * given the firmware ELF.
+ *
+ * The CMake firmware build links with a copy of the core linker script that has a
+ * .noinit (NOLOAD) output section. With the stock script the section is an orphan that
+ * ld places after .bss. It then shares RAM with the heap, so the record only survives
+ * if nothing was allocated over it; the checksum rejects it otherwise.
+ */
+
+#define CRASH_STACK_WORDS 32
+#define CRASH_THREADS 8 // Threads::MAX_THREADS
+
+enum CrashReason {
+  CRASH_NONE,
+  CRASH_HARD_FAULT,
+  CRASH_MEM_FAULT,
+  CRASH_BUS_FAULT,
+  CRASH_USAGE_FAULT,
+  CRASH_STACK_OVERFLOW
+};
+
+// Enable the configurable fault handlers and report a crash from the previous run
+void setupCrash();
+
+bool crashPresent();
+void crashClear();
+
+class Print;
+// Print the stored dump as text; nothing if there is none
+void crashReport(Print &out);
+
+
+#endif // CRASH_H
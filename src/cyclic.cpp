@@ -0,0 +1,111 @@
+#include <Arduino.h>
+
+#include "cyclic.h"
+#include "config.h"
+#include "display.h"
+#include "game.h"
+#include "link.h"
+#include "menu.h"
+#include "selftest.h"
+#include "statusled.h"
+#include "telemetry.h"
+#include "timebase.h"
+
+
+static void taskGame() {
+  gameUpdate();
+  gamePoll();
+}
+
+static void taskSelfTest() { selfTestPoll(); }
+static void taskLink() { linkPoll(); }
+static void taskTelemetry() { telemetryPoll(); }
+static void taskButtons() { menuPoll(); }
+static void taskDisplay() { displayUpdate(); }
+static void taskStatusLed() { statusLedUpdate(millis()); }
+static void taskConfig() { configFlush(); }
+
+static const struct {
+  const char *name;
+  void (*run)();
+  uint8_t offset;
+  uint8_t period;
+} schedule[] = CYCLIC_SCHEDULE;
+
+#define TASK_COUNT (sizeof(schedule) / sizeof(schedule[0]))
+
+static struct {
+  uint32_t runs;
+  uint32_t lastUs;
+  uint32_t maxUs;
+} taskStats[TASK_COUNT];
+
+static bool running;
+static uint64_t frameStart; // when the next minor frame is due
+static uint8_t frame;       // its number in the major frame
+static uint32_t frames, overruns, skipped, maxFrameUs;
+
+
+void setupCyclic() {
+  memset(taskStats, 0, sizeof(taskStats));
+  frames = overruns = skipped = maxFrameUs = 0;
+  frame = 0;
+  frameStart = timeMicros();
+  running = true;
+}
+
+void cyclicPoll() {
+  if (!running) return;
+  uint64_t now = timeMicros();
+  if (now < frameStart) return;
+
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    if ((uint8_t)(frame + CYCLIC_MINOR_FRAMES - schedule[i].offset) % schedule[i].period) continue;
+    uint64_t start = timeMicros();
+    schedule[i].run();
+    uint32_t us = (uint32_t)(timeMicros() - start);
+    taskStats[i].runs++;
+    taskStats[i].lastUs = us;
+    if (us > taskStats[i].maxUs) taskStats[i].maxUs = us;
+  }
+
+  uint64_t end = timeMicros();
+  uint32_t frameUs = (uint32_t)(end - frameStart);
+  if (frameUs > maxFrameUs) maxFrameUs = frameUs;
+  frames++;
+
+  // next frame on the grid; frames whose start has already passed are skipped
+  uint32_t advance = 1;
+  if (end >= frameStart + CYCLIC_MINOR_US) {
+    overruns++;
+    advance = (uint32_t)((end - frameStart) / CYCLIC_MINOR_US) + 1;
+    skipped += advance - 1;
+  }
+  frameStart += (uint64_t)advance * CYCLIC_MINOR_US;
+  frame = (frame + advance) % CYCLIC_MINOR_FRAMES;
+}
+
+void cyclicStatus(CyclicStatus *out) {
+  out->running = running;
+  out->tasks = TASK_COUNT;
+  out->minorUs = CYCLIC_MINOR_US;
+  out->minorFrames = CYCLIC_MINOR_FRAMES;
+  out->frames = frames;
+  out->overruns = overruns;
+  out->skipped = skipped;
+  out->maxFrameUs = maxFrameUs;
+}
+
+const char *cyclicTaskName(uint8_t task) {
+  return task < TASK_COUNT ? schedule[task].name : NULL;
+}
+
+bool cyclicTask(uint8_t task, CyclicTaskStatus *out) {
+  if (task >= TASK_COUNT) return false;
+  out->offset = schedule[task].offset;
+  out->period = schedule[task].period;
+  out->runs = taskStats[task].runs;
+  out->lastUs = taskStats[task].lastUs;
+  out->maxUs = taskStats[task].maxUs;
+  return true;
+}
@@ -0,0 +1,82 @@
+#ifndef CYCLIC_H
+#define CYCLIC_H
+
+#include <stdint.h>
+
+
+/* CYCLIC EXECUTIVE
+ * ==========================================================================================
+ * Built with HOTSHOT_CYCLIC, the firmware runs the game, its I/O and the service tasks from
+ * a fixed, time-triggered schedule on the main stack instead of TeensyThreads: no context
+ * switches, no thread stacks, and the same order every time. Without it the threads in
+ * main.cpp run as before.
+ *
+ * Time is cut into minor frames of CYCLIC_MINOR_US; CYCLIC_MINOR_FRAMES of them make a
+ * major frame, after which the schedule repeats. Each task runs in the minor frames where
+ * (frame - offset) is a multiple of its period (which divides CYCLIC_MINOR_FRAMES), in
+ * CYCLIC_SCHEDULE order:
+ *
+ * Task         Runs                                         Offset  Period
+ * ------------------------------------------------------------------------------------------
+ * game         gameUpdate(), gamePoll(): inputs, state       0       1 (1 ms)
+ *              machine, outputs
+ * self-test    selfTestPoll()                               0       1
+ * link         linkPoll()                                   0       1
+ * telemetry    telemetryPoll()                              1       2
+ * buttons      menuPoll()                                   1       5
+ * display      displayUpdate()                              2       10 (DISPLAY_REFRESH_MS)
+ * status led   statusLedUpdate()                            3       10
+ * config       configFlush(): one EEPROM setting a call     9       10
+ *
+ * cyclicPoll() starts the next minor frame when it is due and otherwise returns at once, so
+ * loop() (or the simulator's step) just keeps calling it. A frame that is still running when
+ * the next one is due is an overrun: the missed frames are counted and skipped rather than
+ * run late, so the schedule never drifts. The execution time of every task run is measured,
+ * and hsctl tasks shows each task's runs, last and worst-case execution time.
+ */
+
+#define CYCLIC_MINOR_US 1000
+#define CYCLIC_MINOR_FRAMES 10
+
+// Name, task, offset and period (minor frames); the tasks are in cyclic.cpp
+#define CYCLIC_SCHEDULE {                     \
+  { "game", taskGame, 0, 1 },                 \
+  { "self-test", taskSelfTest, 0, 1 },        \
+  { "link", taskLink, 0, 1 },                 \
+  { "telemetry", taskTelemetry, 1, 2 },       \
+  { "buttons", taskButtons, 1, 5 },           \
+  { "display", taskDisplay, 2, 10 },          \
+  { "status led", taskStatusLed, 3, 10 },     \
+  { "config", taskConfig, 9, 10 },            \
+}
+
+typedef struct {
+  uint8_t offset;
+  uint8_t period;
+  uint32_t runs;
+  uint32_t lastUs;
+  uint32_t maxUs;  // worst-case execution time
+} CyclicTaskStatus;
+
+typedef struct {
+  bool running;          // the firmware runs on the schedule
+  uint8_t tasks;
+  uint32_t minorUs;
+  uint8_t minorFrames;
+  uint32_t frames;       // minor frames run
+  uint32_t overruns;     // minor frames that ran past the start of the next
+  uint32_t skipped;      // minor frames skipped to catch up
+  uint32_t maxFrameUs;   // longest minor frame
+} CyclicStatus;
+
+// Start the schedule at minor frame 0, now
+void setupCyclic();
+// Run the next minor frame if it is due
+void cyclicPoll();
+
+void cyclicStatus(CyclicStatus *out);
+const char *cyclicTaskName(uint8_t task);
+bool cyclicTask(uint8_t task, CyclicTaskStatus *out);
+
+
+#endif // CYCLIC_H
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+
+#include <FastPin.h>
+#include <LedControl.h> // charTable
+
+#include "display.h"
+#include "config.h"
+#include "game.h"
+#include "menu.h"
+#include "selftest.h"
+#include "pins.h"
+#include "probes.h"
+
+
+#define SEGMENT_DP 0x80
+#define SEGMENT_P 0x67  // the letter P
+
+// MAX7219 registers
+#define MAX7219_NOOP 0x00
+#define MAX7219_DIGIT0 0x01
+#define MAX7219_DECODE_MODE 0x09
+#define MAX7219_INTENSITY 0x0A
+#define MAX7219_SCAN_LIMIT 0x0B
+#define MAX7219_SHUTDOWN 0x0C
+#define MAX7219_DISPLAY_TEST 0x0F
+
+typedef FastShiftOut<DISPLAY_SDATA_OUT, DISPLAY_CLOCK_OUT, MSBFIRST, DISPLAY_CLOCK_HOLD> DisplayBus;
+typedef Pin<DISPLAY_STROBE_OUT> DisplayStrobe;
+typedef Pin<DISPLAY_ENABLE_OUT> DisplayEnable;
+
+static bool ready;
+static uint8_t shown[DISPLAY_COUNT][DISPLAY_DIGITS]; // segments on the displays now
+static uint32_t writes;
+
+
+// Right-aligned, leading zeros blanked; with 'tenths' the last digit is tenths
+static void render(uint16_t value, bool tenths, uint8_t *segments) {
+  for (uint8_t i = 0; i < DISPLAY_DIGITS; i++) {
+    bool blank = value == 0 && i > (tenths ? 1 : 0);
+    segments[i] = blank ? 0 : pgm_read_byte(&charTable[value % 10]);
+    value /= 10;
+  }
+  if (tenths) segments[1] |= SEGMENT_DP;
+}
+
+// One register on one display; the others in the chain get a no-op. The chain shifts
+// the far end first, so display 0 is the last one out.
+static void writeRegister(uint8_t display, uint8_t reg, uint8_t data) {
+  DisplayStrobe::low();
+  for (int8_t d = DISPLAY_COUNT - 1; d >= 0; d--) {
+    DisplayBus::write(d == display ? reg : MAX7219_NOOP);
+    DisplayBus::write(d == display ? data : 0);
+  }
+  DisplayStrobe::high(); // latched on the rising edge
+}
+
+static void show(uint8_t display, const uint8_t *segments) {
+  for (uint8_t i = 0; i < DISPLAY_DIGITS; i++) {
+    if (segments[i] == shown[display][i]) continue;
+    writeRegister(display, MAX7219_DIGIT0 + i, segments[i]);
+    shown[display][i] = segments[i];
+    writes++;
+  }
+}
+
+void setupDisplay() {
+  DisplayEnable::output();
+  DisplayEnable::low(); // active low
+  DisplayStrobe::output();
+  DisplayStrobe::high();
+  DisplayBus::begin();
+
+  for (uint8_t d = 0; d < DISPLAY_COUNT; d++) {
+    writeRegister(d, MAX7219_DISPLAY_TEST, 0);
+    writeRegister(d, MAX7219_SCAN_LIMIT, DISPLAY_DIGITS - 1);
+    writeRegister(d, MAX7219_DECODE_MODE, 0); // raw segments
+    writeRegister(d, MAX7219_INTENSITY, DISPLAY_INTENSITY);
+    for (uint8_t i = 0; i < DISPLAY_DIGITS; i++) writeRegister(d, MAX7219_DIGIT0 + i, 0);
+    writeRegister(d, MAX7219_SHUTDOWN, 1); // normal operation
+  }
+  memset(shown, 0, sizeof(shown));
+  ready = true;
+}
+
+void displayUpdate() {
+  if (!ready) return;
+  PROBE_SCOPE(PROBE_DISPLAY);
+
+  uint8_t segments[DISPLAY_DIGITS];
+
+  if (selfTestActive()) {
+    uint8_t input;
+    bool active;
+    uint32_t us;
+    if (selfTestStep() == SELFTEST_DISPLAYS) {
+      memset(segments, 0xFF, sizeof(segments));
+      show(DISPLAY_TIME, segments);
+      show(DISPLAY_SCORE, segments);
+      return;
+    }
+    bool seen = selfTestLast(&input, &active, &us);
+    render(seen ? (us > 9999 ? 9999 : us) : 0, false, segments);
+    show(DISPLAY_TIME, segments);
+    render(seen ? input + 1 : 0, false, segments);
+    if (seen && active) segments[0] |= SEGMENT_DP;
+    show(DISPLAY_SCORE, segments);
+    return;
+  }
+
+  if (menuActive()) { // "P  3" and the value
+    render(menuItem(), false, segments);
+    segments[DISPLAY_DIGITS - 1] = SEGMENT_P;
+    show(DISPLAY_TIME, segments);
+    render(menuValue(), false, segments);
+    show(DISPLAY_SCORE, segments);
+    return;
+  }
+
+  GameState state = curGameState;
+
+  if (state == GameState::GS_LAST10) render(remainingGameTenths, true, segments);
+  else if (state == GameState::GS_RUN) render(remainingGameSec, false, segments);
+  else render(playTime, false, segments);
+  show(DISPLAY_TIME, segments);
+
+  render(state == GameState::GS_ATTRACT ? lastScore : curScore, false, segments);
+  show(DISPLAY_SCORE, segments);
+}
+
+uint32_t displayWrites() {
+  return writes;
+}
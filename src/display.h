@@ -0,0 +1,36 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+
+
+/* DISPLAYS
+ * ==========================================================================================
+ * The TIME and SCORE 7-segment displays, a MAX7219 each, chained on the DISPLAY_* pins
+ * (pins.h) and bit-banged with FastShiftOut (lib/FastPin). Digit 0 is the rightmost.
+ *
+ * TIME    GS_RUN: seconds left; GS_LAST10: seconds and tenths ("9.9"); otherwise the
+ *         play time
+ * SCORE   the score of the game in progress, or of the last game
+ *
+ * The operator menu (menu.h) and the self-test (selftest.h) take both over while they run.
+ *
+ * displayUpdate() works out both and writes only the digits that differ from what the
+ * displays already show, so a refresh with nothing new costs no writes at all and the
+ * ten updates a second of the tenths countdown each touch one digit, rarely two or three.
+ */
+
+#define DISPLAY_TIME 0
+#define DISPLAY_SCORE 1
+#define DISPLAY_COUNT 2
+#define DISPLAY_DIGITS 4
+#define DISPLAY_INTENSITY 8   // 0..15
+#define DISPLAY_REFRESH_MS 10 // how often the display thread calls displayUpdate()
+#define DISPLAY_CLOCK_HOLD 2  // nops per clock edge: the MAX7219 needs 50 ns high and low
+
+void setupDisplay();
+void displayUpdate();
+uint32_t displayWrites(); // digit registers written since boot
+
+
+#endif // DISPLAY_H
@@ -0,0 +1,345 @@
+#include <Arduino.h>
+
+#include <FastPin.h>
+
+#include "game.h"
+#include "config.h"
+#include "irq.h"
+#include "link.h"
+#include "menu.h"
+#include "optomon.h"
+#include "pins.h"
+#include "probes.h"
+#include "record.h"
+#include "selftest.h"
+#include "shots.h"
+#include "supply.h"
+#include "timebase.h"
+
+
+volatile uint8_t curScore;
+uint8_t lastScore, curCredits;
+uint16_t curTickets;
+volatile uint32_t gamesPlayed, coinsAccepted, ticketsDispensed;
+
+IntervalTimer gameTimer, attractTimer;
+
+typedef Pin<TICKET_NOTCH_OUT> TicketNotch;
+typedef Pin<TICKET_COUNTER_OUT> TicketCounter;
+typedef Pin<BALL_GATE_OUT> BallGate;
+
+volatile GameState curGameState = GameState::GS_ATTRACT;
+volatile uint8_t lastGameSec;
+volatile uint8_t remainingGameSec;
+volatile uint16_t remainingGameTenths;
+volatile bool doAttract;
+
+volatile bool coin1in;
+volatile uint64_t lastCoin1Millis;
+uint16_t coinDelay = 2500; // time to wait before accepting another credit
+
+volatile bool gameTick;
+volatile bool delayNextGame;
+
+// state entry tracking, so that a state can be entered from loop() (handleCredit) too
+static GameState lastGameState = GameState::GS_ATTRACT;
+static uint32_t stateDeadline;
+
+// "Starting next game in 10 seconds" countdown
+static bool nextGameCountdown;
+static uint32_t nextGameStartMillis;
+static uint8_t nextGameDots;
+
+// a ball broke the upper beam at shotMicros and has not reached the lower one yet
+static volatile bool shotArmed;
+static volatile uint64_t shotMicros;
+
+// ticket payout
+static int16_t ticketsToDispense;
+static bool ticketPulseActive;
+static uint32_t nextTicketEdgeMillis;
+
+
+void attractCallback() {
+  IRQ_TIMER_SCOPE(IRQ_SRC_ATTRACT, attractTimer);
+  recordEvent(REC_TICK, REC_ATTRACT, 0);
+  if (curGameState == GameState::GS_ATTRACT) {
+    doAttract = true;
+  }
+}
+
+void dispenseTickets(int16_t tickets) {
+  ticketsToDispense += tickets;
+}
+
+bool ticketsPending() {
+  return ticketsToDispense > 0 || ticketPulseActive;
+}
+
+int16_t ticketsQueued() {
+  return ticketsToDispense;
+}
+
+static void serviceTickets(uint32_t now) {
+  if (!ticketsPending()) return;
+  if ((int32_t)(now - nextTicketEdgeMillis) < 0) return;
+
+  PROBE_SCOPE(PROBE_DISPENSE);
+
+  if (!ticketPulseActive) {
+    TicketNotch::low();
+    TicketCounter::high();
+    ticketPulseActive = true;
+  } else {
+    TicketNotch::high();
+    TicketCounter::low();
+    ticketPulseActive = false;
+    ticketsToDispense--;
+    ticketsDispensed++;
+  }
+  nextTicketEdgeMillis = now + TICKET_PULSE_DELAY;
+}
+
+void gameTimerCallback() {
+  IRQ_TIMER_SCOPE(IRQ_SRC_GAME_TIMER, gameTimer);
+  PROBE_SCOPE(PROBE_GAME_TIMER);
+  if (optoHoldGame()) return; // the clock stops while a beam is jammed or chattering, up to OPTO_HOLD_MAX_MS (optomon.h)
+  if (remainingGameTenths) remainingGameTenths--;
+  if (remainingGameTenths % 10) return; // the rest happens on whole seconds
+
+  gameTick = true;
+  remainingGameSec = remainingGameTenths / 10;
+  recordEvent(REC_TICK, REC_GAME, remainingGameSec);
+}
+
+// A linked opponent (link.h) sets the start time; otherwise the get-ready delay does
+static bool startDue(uint32_t now) {
+  int8_t link = linkStartCheck();
+  return link > 0 || (link < 0 && (int32_t)(now - stateDeadline) >= 0);
+}
+
+void gameUpdate() {
+  PROBE_SCOPE(PROBE_GAME_UPDATE);
+  uint32_t now = millis();
+
+  serviceTickets(now);
+  optoMonitorCheck(now);
+  supplyMonitorCheck(now);
+
+  if (delayNextGame && curGameState == GameState::GS_ATTRACT) {
+    if (!nextGameCountdown) {
+      Serial.print("Starting next game in 10 seconds");
+      nextGameCountdown = true;
+      nextGameStartMillis = now;
+      nextGameDots = 0;
+    }
+    while (nextGameDots < NEXT_GAME_DELAY_SEC && now - nextGameStartMillis >= (nextGameDots + 1) * 1000UL) {
+      Serial.print('.');
+      nextGameDots++;
+    }
+    if (nextGameDots < NEXT_GAME_DELAY_SEC) return;
+    Serial.println();
+    nextGameCountdown = false;
+    curGameState = GameState::GS_START;
+  }
+
+  GameState state = curGameState;
+  bool entered = (state != lastGameState);
+  lastGameState = state;
+  if (entered) recordEvent(REC_STATE, (uint8_t)state, curScore);
+
+  switch(state) {
+    case GameState::GS_START:
+      if (entered) {
+        curCredits--; // use 1 credit
+        gamesPlayed++;
+
+        delayNextGame = (curCredits >= 1 && curGameState != GameState::GS_ATTRACT);
+
+        Serial.print("Game started, new balance: ");
+        Serial.println(curCredits);
+        // play "Get ready" sound?
+        stateDeadline = now + GET_READY_DELAY_MS; // wait for player to get ready
+        linkStartBegin();
+      }
+      if (startDue(now)) {
+        BallGate::high();
+        // delay timer start for balls to come out?
+        remainingGameSec = playTime;
+        remainingGameTenths = playTime * 10;
+        shotsBeginGame();
+        optoMonitorGameStart();
+        gameTimer.begin(gameTimerCallback, GAME_TIMER_US);
+        curGameState = GameState::GS_RUN; // move to next state
+      }
+      break;
+    case GameState::GS_RUN:
+      // scores are counted by the opto ISRs (optoInput)
+      if (remainingGameSec <= 10) {
+        curGameState = GameState::GS_LAST10;
+      }
+      break;
+    case GameState::GS_LAST10:
+      // do lights and sound
+      if (remainingGameSec <= 0) {
+        curGameState = GameState::GS_END;
+      }
+      break;
+    case GameState::GS_END:
+      if (entered) {
+        gameTimer.end();
+        BallGate::low(); // close ball gate
+        shotsEndGame();
+        optoMonitorGameEnd();
+
+        if (curScore > highScore) {
+          Serial.println("Beat high score"); // do something??
+        }
+
+        dispenseTickets(curScore * ticketsPerScore); // dispense tickets
+        lastScore = curScore;
+      }
+
+      if (!ticketsPending()) {
+        Serial.print("Game ended, Final score: ");
+        Serial.print(lastScore);
+        Serial.print(", Tickets earned: ");
+        Serial.println(lastScore * ticketsPerScore);
+
+        curScore = 0; // shown until the tickets are out
+        curGameState = GameState::GS_ATTRACT;
+      }
+      break;
+    case GameState::GS_ATTRACT:
+      if (doAttract) {
+        // do something attractive ;)
+        doAttract = false;
+      }
+
+      break;
+  }
+}
+
+bool gameIdle() {
+  return curGameState == GameState::GS_ATTRACT && !delayNextGame && curCredits == 0 && !ticketsPending();
+}
+
+void coinInput() {
+  recordEvent(REC_COIN, 0, 1);
+  uint64_t now = timeMillis();
+  // the first coin is always good; measuring from time 0 would refuse coins for coinDelay after boot
+  if (!coinsAccepted || now - lastCoin1Millis > coinDelay) {
+    curCredits++;
+    coinsAccepted++;
+    coin1in = true;
+    lastCoin1Millis = now;
+  }
+}
+
+void optoInput(uint8_t opto, uint8_t level) {
+  recordEvent(REC_OPTO, opto, level);
+  optoMonitorEdge(opto, level == OPTO_BLOCKED);
+  if (level != OPTO_BLOCKED) return;
+
+  uint64_t now = timeMicros();
+  GameState state = curGameState;
+  bool playing = (state == GameState::GS_RUN || state == GameState::GS_LAST10) && !optoHoldScoring();
+  bool late = shotArmed && now - shotMicros > SCORE_WINDOW_MS * 1000UL;
+
+  if (opto == OPTO_UPPER) {
+    if (late && playing) shotMissed(); // the last ball never came through
+    shotArmed = true;
+    shotMicros = now;
+    return;
+  }
+
+  // upper then lower beam: the ball went through the hoop
+  if (shotArmed && playing) {
+    if (!late) curScore += 1 + shotScored((uint32_t)(now - shotMicros));
+    else shotMissed();
+  }
+  shotArmed = false;
+}
+
+void coin1ISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTA);
+  PROBE_SCOPE(PROBE_COIN_ISR);
+  if (selfTestActive()) selfTestCapture(SELFTEST_IN_COIN, true);
+  else if (!replayMode()) coinInput();
+}
+
+void upperOptoISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTD);
+  PROBE_SCOPE(PROBE_OPTO_ISR);
+  if (selfTestActive()) selfTestCapture(SELFTEST_IN_UPPER, digitalReadFast(UPPER_OPTO_IN) == OPTO_BLOCKED);
+  else if (!replayMode()) optoInput(OPTO_UPPER, digitalReadFast(UPPER_OPTO_IN));
+}
+
+void lowerOptoISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTA);
+  PROBE_SCOPE(PROBE_OPTO_ISR);
+  if (selfTestActive()) selfTestCapture(SELFTEST_IN_LOWER, digitalReadFast(LOWER_OPTO_IN) == OPTO_BLOCKED);
+  else if (!replayMode()) optoInput(OPTO_LOWER, digitalReadFast(LOWER_OPTO_IN));
+}
+
+void setupIO() {
+  pinMode(UPPER_OPTO_IN, INPUT);
+  pinMode(LOWER_OPTO_IN, INPUT);
+  pinMode(COIN1_IN, INPUT_PULLUP);
+  pinMode(AUX1_IN, INPUT_PULLUP);
+  pinMode(AUX2_IN, INPUT_PULLUP);
+  pinMode(RESET_IN, INPUT_PULLUP);
+
+  attachInterrupt(digitalPinToInterrupt(COIN1_IN), coin1ISR, RISING);
+  attachInterrupt(digitalPinToInterrupt(UPPER_OPTO_IN), upperOptoISR, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(LOWER_OPTO_IN), lowerOptoISR, CHANGE);
+
+  pinMode(TICKET_COUNTER_OUT, OUTPUT);
+  pinMode(CREDIT_COUNTER_OUT, OUTPUT);
+  pinMode(TICKET_NOTCH_OUT, OUTPUT);
+  pinMode(BALL_GATE_OUT, OUTPUT);
+
+  // display
+  pinMode(DISPLAY_ENABLE_OUT, OUTPUT);
+  pinMode(DISPLAY_STROBE_OUT, OUTPUT);
+  pinMode(DISPLAY_SDATA_OUT, OUTPUT);
+  pinMode(DISPLAY_CLOCK_OUT, OUTPUT);
+
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  TicketNotch::high(); // active low
+  digitalWriteFast(LED_BUILTIN, HIGH); // goes low in status thread
+}
+
+void setupTimers() {
+  attractTimer.begin(attractCallback, SEC_TO_MICROSEC(attractTime));
+}
+
+void applySetting(uint8_t field) {
+  if (field == CFG_ATTRACT_TIME) setupTimers();
+}
+
+static void handleCredit() {
+  Serial.print("Got Credit, new balance: ");
+  Serial.println(curCredits);
+  menuClose(); // a player wants the cabinet back
+  if (curCredits >= 1 && curGameState == GameState::GS_ATTRACT) {
+    curGameState = GameState::GS_START;
+  } else if (curCredits >= 1 && curGameState != GameState::GS_ATTRACT) {
+    delayNextGame = true;
+    Serial.println("Delaying next game by 10sec");
+  }
+}
+
+void gamePoll() {
+  if (coin1in) {
+    handleCredit();
+    coin1in = false;
+  }
+
+  if (gameTick) {
+    Serial.print("Game time left: ");
+    Serial.println(remainingGameSec);
+    gameTick = false;
+  }
+}
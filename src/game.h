@@ -0,0 +1,90 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+
+
+/* GLOBALS
+ * ====================================================================================================
+ * Variable Name      Type       Default    Description
+ * ====================================================================================================
+ * curScore           uint8_t     0         number of balls scored in current game
+ * lastScore          uint8_t     0         number of balls scored in last game
+ * curTickets         uint16_t    0         number of tickets earned in current game
+ * curCredits         uint8_t     0         current available credits
+ * gamesPlayed        uint32_t    0         games started since boot
+ * coinsAccepted      uint32_t    0         coins credited since boot
+ * ticketsDispensed   uint32_t    0         tickets paid out since boot
+ *
+ * DEFINES
+ * TICKET_PULSE_DELAY             time between ticket pulses in ms
+ * SCORE_WINDOW_MS                longest upper-to-lower opto time that still counts as a basket
+ * GAME_TIMER_US                  game clock resolution: the timer counts down tenths of a second
+ *
+ * TODOs (Sound/lights)
+ */
+
+#define SEC_TO_MICROSEC(x) x * 1000000
+
+#define TICKET_PULSE_DELAY 20
+#define GET_READY_DELAY_MS 2500
+#define NEXT_GAME_DELAY_SEC 10
+#define SCORE_WINDOW_MS 500
+#define GAME_TIMER_US 100000
+
+#define OPTO_UPPER 0
+#define OPTO_LOWER 1
+
+enum class GameState {
+  GS_START,
+  GS_RUN,
+  GS_LAST10,
+  GS_END,
+  GS_ATTRACT // attract
+};
+
+extern volatile uint8_t curScore;
+extern uint8_t lastScore, curCredits;
+extern uint16_t curTickets;
+extern volatile uint32_t gamesPlayed, coinsAccepted, ticketsDispensed;
+
+extern volatile GameState curGameState;
+extern volatile uint8_t remainingGameSec;
+extern volatile uint16_t remainingGameTenths; // remainingGameSec rounds this down to whole seconds
+extern volatile bool delayNextGame;
+
+void setupIO();
+void setupTimers();
+// Put a changed setting (ConfigField) into effect; only the attract timer needs restarting,
+// the rest are read when used
+void applySetting(uint8_t field);
+
+/*
+ * The game engine never blocks. gameUpdate() advances the state machine as
+ * far as the current millis() allows and returns; it is called continuously
+ * from the game thread on the device and from the simulator on the host.
+ * gamePoll() services the flags raised by the ISRs and runs from loop().
+ */
+void gameUpdate();
+void gamePoll();
+
+// Queue tickets on the notch/counter outputs; pulses are paced by gameUpdate()
+void dispenseTickets(int16_t tickets);
+bool ticketsPending();
+int16_t ticketsQueued();
+
+// Attract mode with no credits, tickets or queued game
+bool gameIdle();
+
+// Input handlers; the ISRs read the pins and call these, replay calls them directly
+void coinInput();
+void optoInput(uint8_t opto, uint8_t level);
+
+void coin1ISR();
+void upperOptoISR();
+void lowerOptoISR();
+void gameTimerCallback();
+void attractCallback();
+
+
+#endif // GAME_H
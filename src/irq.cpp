@@ -0,0 +1,126 @@
+#include <Arduino.h>
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#endif
+
+#include "irq.h"
+#include "timebase.h"
+
+
+static const struct {
+  const char *name;
+  uint8_t priority;
+  uint16_t budgetUs;
+} plan[IRQ_SRC_COUNT] = IRQ_PLAN;
+
+static struct {
+  volatile uint32_t count;
+  volatile uint32_t maxRun;
+  volatile uint32_t maxLatency;
+  volatile uint32_t overBudget;
+} stats[IRQ_SRC_COUNT];
+
+extern IntervalTimer gameTimer, attractTimer; // game.cpp
+
+
+#if defined(__arm__)
+
+#define IRQ_TICKS_PER_US (F_CPU / 1000000)
+
+uint32_t irqTicks() {
+  return ARM_DWT_CYCCNT;
+}
+
+uint32_t irqTimerLatency(IntervalTimer &timer) {
+  KINETISK_PIT_CHANNEL_t *pit = KINETISK_PIT_CHANNELS + ((IRQ_NUMBER_t)timer - IRQ_PIT_CH0);
+  return (pit->LDVAL - pit->CVAL) * (F_CPU / F_BUS); // the PIT counts down at F_BUS
+}
+
+static void applyPlan() {
+  NVIC_SET_PRIORITY(IRQ_PORTA, plan[IRQ_SRC_PORTA].priority);
+  NVIC_SET_PRIORITY(IRQ_PORTD, plan[IRQ_SRC_PORTD].priority);
+  SCB_SHPR3 = (SCB_SHPR3 & 0x00FFFFFF) | ((uint32_t)plan[IRQ_SRC_SYSTICK].priority << 24);
+  SCB_SHPR2 = (SCB_SHPR2 & 0x00FFFFFF) | ((uint32_t)plan[IRQ_SRC_SVCALL].priority << 24);
+  NVIC_SET_PRIORITY(IRQ_UART0_STATUS, plan[IRQ_SRC_LINK].priority);
+  NVIC_SET_PRIORITY(IRQ_USBOTG, plan[IRQ_SRC_USB].priority);
+  NVIC_SET_PRIORITY(IRQ_ADC1, plan[IRQ_SRC_ADC].priority);
+
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+// The longest context switch, which runs masked and so can hold off any edge
+static uint32_t switchTicks() {
+  return threads.getMaxSwitchCycles();
+}
+
+#else
+
+#define IRQ_TICKS_PER_US 1
+
+uint32_t irqTicks() {
+  return (uint32_t)timeMicros();
+}
+
+uint32_t irqTimerLatency(IntervalTimer &) {
+  return 0; // simulated timers fire exactly on time
+}
+
+static void applyPlan() {
+}
+
+static uint32_t switchTicks() {
+  return 0; // no threads in the simulator
+}
+
+#endif // __arm__
+
+
+void setupInterrupts() {
+  applyPlan();
+  // kept by the timers and applied on every begin()
+  gameTimer.priority(plan[IRQ_SRC_GAME_TIMER].priority);
+  attractTimer.priority(plan[IRQ_SRC_ATTRACT].priority);
+}
+
+void irqRecord(uint8_t source, uint32_t runTicks, uint32_t latencyTicks) {
+  if (source >= IRQ_SRC_COUNT) return;
+  stats[source].count++;
+  if (runTicks > stats[source].maxRun) stats[source].maxRun = runTicks;
+  if (latencyTicks > stats[source].maxLatency) stats[source].maxLatency = latencyTicks;
+  if (latencyTicks > (uint32_t)plan[source].budgetUs * IRQ_TICKS_PER_US) stats[source].overBudget++;
+}
+
+static uint32_t ticksToNs(uint64_t ticks) {
+  uint64_t ns = ticks * 1000 / IRQ_TICKS_PER_US;
+  return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+const char *irqName(uint8_t source) {
+  return source < IRQ_SRC_COUNT ? plan[source].name : NULL;
+}
+
+bool irqStatus(uint8_t source, IrqStatus *out) {
+  if (source >= IRQ_SRC_COUNT) return false;
+  out->priority = plan[source].priority;
+  out->budgetUs = plan[source].budgetUs;
+  out->count = stats[source].count;
+  out->maxRunNs = ticksToNs(stats[source].maxRun);
+  out->measured = source == IRQ_SRC_GAME_TIMER || source == IRQ_SRC_ATTRACT;
+
+  if (out->measured) {
+    out->maxLatencyNs = ticksToNs(stats[source].maxLatency);
+    out->overBudget = stats[source].overBudget;
+    return true;
+  }
+
+  // everything that can run ahead of an edge, once each
+  uint64_t bound = switchTicks();
+  for (uint8_t i = 0; i < IRQ_SRC_COUNT; i++) {
+    if (plan[i].budgetUs && plan[i].priority <= plan[source].priority) bound += stats[i].maxRun;
+  }
+  out->maxLatencyNs = plan[source].budgetUs ? ticksToNs(bound) : 0;
+  out->overBudget = plan[source].budgetUs && bound > (uint64_t)plan[source].budgetUs * IRQ_TICKS_PER_US;
+  return true;
+}
@@ -0,0 +1,114 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+
+/* INTERRUPT PRIORITIES
+ * ==========================================================================================
+ * Every interrupt the firmware uses gets its NVIC priority from IRQ_PLAN, and
+ * setupInterrupts() applies the whole plan in one place once the libraries have set their
+ * defaults (Serial1.begin() in setupLink sets its own). The K20 implements four priority
+ * bits, so priorities are multiples of 16 and lower is more urgent. A port interrupt covers
+ * every pin of its port, so pins on the same port share one priority:
+ *
+ * Source              Serves                                       Priority  Budget
+ * ------------------------------------------------------------------------------------------
+ * IRQ_SRC_PORTA       COIN1_IN (PTA13), LOWER_OPTO_IN (PTA12)      16        10 us
+ * IRQ_SRC_PORTD       UPPER_OPTO_IN (PTD0), AUX1/AUX2/RESET         16        10 us
+ *                     (self-test only)
+ * IRQ_SRC_SYSTICK     millis(), TeensyThreads context switch       48        -
+ * IRQ_SRC_SVCALL      TeensyThreads context switch from yield()    48        -
+ *                     (svc)
+ * IRQ_SRC_GAME_TIMER  gameTimer (PIT), the game clock              64        100 us
+ * IRQ_SRC_LINK        Serial1 (UART0 status), cabinet link         80        -
+ * IRQ_SRC_ATTRACT     attractTimer (PIT)                           96        1000 us
+ * IRQ_SRC_USB         USB serial: log text and telemetry           112       -
+ * IRQ_SRC_ADC         ADC1 conversion done, supply monitor         128       1000 us
+ *                     (supply.h)
+ *
+ * Inputs come first: a coin or opto edge preempts everything else but the other inputs and
+ * the context switch itself. The switch never happens from inside another ISR (TeensyThreads
+ * checks), so both of its exceptions, SysTick and SVCall, can sit below the inputs; it runs
+ * with interrupts masked, though, so an edge can still wait for one switch to finish. The
+ * firmware uses no DMA.
+ *
+ * The budget is the longest entry latency the source may see: from the request to the
+ * first instruction of the handler. It is checked at run time two ways:
+ *
+ * Measured   PIT sources: the handler reads how far the PIT has counted down since it
+ *            expired (IRQ_TIMER_SCOPE), which is exactly the entry latency.
+ * Bound      port sources (no hardware timestamp on an edge): the sum of the longest run
+ *            of every instrumented handler at the same or a higher priority, each of which
+ *            can run once ahead of the edge (IRQ_SCOPE), plus the longest context switch
+ *            (timed by TeensyThreads). Other masked sections are a few instructions and are
+ *            not counted.
+ *
+ * A source over budget is counted (overBudget) and shown by hsctl irqs. Sources without a
+ * budget (0) belong to the core and are not instrumented.
+ */
+
+enum IrqSource {
+  IRQ_SRC_PORTA,
+  IRQ_SRC_PORTD,
+  IRQ_SRC_SYSTICK,
+  IRQ_SRC_SVCALL,
+  IRQ_SRC_GAME_TIMER,
+  IRQ_SRC_LINK,
+  IRQ_SRC_ATTRACT,
+  IRQ_SRC_USB,
+  IRQ_SRC_ADC,
+  IRQ_SRC_COUNT
+};
+
+// Name, priority, budget (us; 0 = not instrumented), in IrqSource order
+#define IRQ_PLAN {                   \
+  { "port A",       16, 10 },        \
+  { "port D",       16, 10 },        \
+  { "systick",      48, 0 },         \
+  { "svcall",       48, 0 },         \
+  { "game timer",   64, 100 },       \
+  { "link uart",    80, 0 },         \
+  { "attract",      96, 1000 },      \
+  { "usb",          112, 0 },        \
+  { "supply adc",   128, 1000 },     \
+}
+
+typedef struct {
+  uint8_t priority;
+  uint16_t budgetUs;
+  uint32_t count;         // handler runs
+  uint32_t maxRunNs;      // longest handler run
+  uint32_t maxLatencyNs;  // PIT sources: longest measured entry latency; ports: the bound
+  uint32_t overBudget;    // PIT sources: runs over budget; ports: 1 while the bound is over
+  bool measured;          // maxLatencyNs is measured rather than bounded
+} IrqStatus;
+
+void setupInterrupts();
+
+// Instrument a handler: IRQ_SCOPE at the top of a port ISR, IRQ_TIMER_SCOPE at the top of an
+// IntervalTimer callback
+#define IRQ_SCOPE(source) IrqScope irqScope_(source)
+#define IRQ_TIMER_SCOPE(source, timer) IrqScope irqScope_(source, irqTimerLatency(timer))
+
+// Ticks are CPU cycles on the Teensy (DWT cycle counter) and microseconds in the simulator
+class IntervalTimer;
+uint32_t irqTimerLatency(IntervalTimer &timer); // ticks since the timer expired
+uint32_t irqTicks();
+void irqRecord(uint8_t source, uint32_t runTicks, uint32_t latencyTicks);
+
+class IrqScope {
+public:
+  IrqScope(uint8_t source, uint32_t latency = 0) : source(source), latency(latency), start(irqTicks()) {}
+  ~IrqScope() { irqRecord(source, irqTicks() - start, latency); }
+private:
+  uint8_t source;
+  uint32_t latency;
+  uint32_t start;
+};
+
+const char *irqName(uint8_t source);
+bool irqStatus(uint8_t source, IrqStatus *out);
+
+
+#endif // IRQ_H
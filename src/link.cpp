@@ -0,0 +1,241 @@
+#include <Arduino.h>
+
+#include <CobsFrame.h>
+
+#include "link.h"
+#include "game.h"
+#include "probes.h"
+
+#if !defined(__arm__)
+#include <unistd.h>
+#endif
+
+
+#define LINK_MAX_PAYLOAD 16
+
+static uint32_t linkId;
+
+static uint8_t rxBuf[COBS_FRAME_MAX(LINK_MAX_PAYLOAD)];
+static CobsFrameDecoder rx(rxBuf, sizeof(rxBuf));
+
+static uint8_t tx[LINK_MAX_PAYLOAD];
+static uint8_t txLen;
+static uint8_t txFrame[COBS_FRAME_MAX(LINK_MAX_PAYLOAD)];
+
+// peer
+static uint32_t peerId;
+static uint32_t lastRxMillis;
+static bool peerSeen;
+static uint8_t peerState = (uint8_t)GameState::GS_ATTRACT;
+static uint8_t peerScore;
+static uint32_t frames, errors;
+
+// clock offset samples
+static struct {
+  int32_t offset;
+  uint32_t rtt;
+} samples[LINK_SAMPLES];
+static uint8_t sampleCount, sampleNext;
+
+// our side
+static uint32_t lastStatusMillis;
+static uint8_t sentState = 0xFF, sentScore;
+
+// synchronized start
+static bool waiting;
+static uint32_t waitStartMillis;
+static bool startSet;
+static uint32_t startMicros; // our clock
+static uint32_t startSentMillis;
+static bool headToHead;
+static bool resultShown;
+
+
+static void put8(uint8_t v) {
+  if (txLen < sizeof(tx)) tx[txLen++] = v;
+}
+
+static void put32(uint32_t v) {
+  for (int i = 0; i < 4; i++) put8(v >> (8 * i));
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void begin(uint8_t type) {
+  txLen = 0;
+  put8(type);
+}
+
+static void send() {
+  size_t n = cobs_frame_encode(tx, txLen, txFrame, sizeof(txFrame));
+  if (n && LINK_SERIAL.availableForWrite() >= (int)n) LINK_SERIAL.write(txFrame, n);
+}
+
+static bool linkUp() {
+  return peerSeen && millis() - lastRxMillis < LINK_TIMEOUT_MS;
+}
+
+static bool isLeader() {
+  return linkId < peerId;
+}
+
+// curScore holds the score until the game is back in attract mode, then lastScore does
+static uint8_t shownScore() {
+  return curGameState == GameState::GS_ATTRACT ? lastScore : curScore;
+}
+
+static void sendStatus() {
+  sentState = (uint8_t)curGameState;
+  sentScore = shownScore();
+  lastStatusMillis = millis();
+  begin(LINK_STATUS);
+  put32(linkId);
+  put32(micros());
+  put8(sentState);
+  put8(sentScore);
+  send();
+}
+
+static int32_t bestOffset(uint32_t *rtt) {
+  int best = 0;
+  for (int i = 1; i < sampleCount; i++) {
+    if (samples[i].rtt < samples[best].rtt) best = i;
+  }
+  *rtt = samples[best].rtt;
+  return samples[best].offset;
+}
+
+static void handleFrame(const uint8_t *p, int len, uint32_t now) {
+  frames++;
+  lastRxMillis = millis();
+
+  switch (p[0]) {
+    case LINK_STATUS:
+      if (len < 11) return;
+      if (!peerSeen || peerId != get32(p + 1)) sampleCount = 0; // new peer: old samples are void
+      peerSeen = true;
+      peerId = get32(p + 1);
+      peerState = p[9];
+      peerScore = p[10];
+      begin(LINK_ECHO);
+      put32(get32(p + 5));
+      put32(now);
+      send();
+      break;
+
+    case LINK_ECHO: {
+      if (len < 9) return;
+      uint32_t t0 = get32(p + 1), t1 = get32(p + 5);
+      uint32_t rtt = now - t0;
+      if (rtt > LINK_TIMEOUT_MS * 1000UL) return; // a stale echo
+      samples[sampleNext].rtt = rtt;
+      samples[sampleNext].offset = (int32_t)(t1 - t0 - rtt / 2);
+      sampleNext = (sampleNext + 1) % LINK_SAMPLES;
+      if (sampleCount < LINK_SAMPLES) sampleCount++;
+      break;
+    }
+
+    case LINK_START: {
+      if (len < 5 || !waiting || isLeader() || !sampleCount) return;
+      uint32_t rtt;
+      startMicros = get32(p + 1) - bestOffset(&rtt);
+      startSet = true;
+      break;
+    }
+  }
+}
+
+static void sendStart() {
+  startSentMillis = millis();
+  begin(LINK_START);
+  put32(startMicros);
+  send();
+}
+
+static void showResult() {
+  if (!headToHead || resultShown) return;
+  if (curGameState != GameState::GS_ATTRACT || peerState != (uint8_t)GameState::GS_ATTRACT) return;
+
+  resultShown = true;
+  Serial.print("Head-to-head: ");
+  Serial.print(lastScore);
+  Serial.print(" - ");
+  Serial.print(peerScore);
+  Serial.println(lastScore > peerScore ? " (win)" : lastScore < peerScore ? " (loss)" : " (draw)");
+}
+
+void setupLink() {
+#if defined(__arm__)
+  linkId = SIM_UIDL ^ SIM_UIDML ^ SIM_UIDMH; // chip serial number
+#else
+  linkId = getpid();
+#endif
+  LINK_SERIAL.begin(LINK_BAUD);
+}
+
+void linkPoll() {
+  PROBE_SCOPE(PROBE_LINK);
+
+  for (int budget = LINK_RX_BUDGET; budget > 0 && LINK_SERIAL.available() > 0; budget--) {
+    int len = rx.push(LINK_SERIAL.read());
+    if (len > 0) handleFrame(rx.data(), len, micros());
+    else if (len < 0) errors++;
+  }
+
+  if ((uint8_t)curGameState != sentState || shownScore() != sentScore ||
+      millis() - lastStatusMillis >= LINK_STATUS_MS) {
+    sendStatus();
+  }
+
+  if (curGameState != GameState::GS_START) waiting = false;
+  showResult();
+}
+
+void linkStartBegin() {
+  waiting = true;
+  waitStartMillis = millis();
+  startSet = false;
+  headToHead = false;
+}
+
+int8_t linkStartCheck() {
+  if (!waiting || !linkUp() || !sampleCount) return -1;
+
+  if (!startSet) {
+    uint8_t s = peerState;
+    if (s == (uint8_t)GameState::GS_START) {
+      if (!isLeader()) return 0; // the leader's LINK_START is on its way
+      startMicros = micros() + GET_READY_DELAY_MS * 1000UL;
+      startSet = true;
+      sendStart();
+    }
+    else if (s == (uint8_t)GameState::GS_ATTRACT && millis() - waitStartMillis < LINK_JOIN_MS) {
+      return 0; // the opponent may still put a coin in
+    }
+    else {
+      return -1; // mid-game or did not join
+    }
+  }
+
+  if ((int32_t)(micros() - startMicros) < 0) {
+    if (isLeader() && millis() - startSentMillis >= LINK_STATUS_MS) sendStart(); // in case it was lost
+    return 0;
+  }
+  waiting = false;
+  headToHead = true;
+  resultShown = false;
+  return 1;
+}
+
+void linkGetStatus(LinkStatus *out) {
+  out->up = linkUp();
+  out->headToHead = headToHead;
+  out->peerState = peerState;
+  out->peerScore = peerScore;
+  out->offset = sampleCount ? bestOffset(&out->rtt) : 0;
+  if (!sampleCount) out->rtt = 0;
+  out->frames = frames;
+  out->errors = errors;
+}
@@ -0,0 +1,75 @@
+#ifndef LINK_H
+#define LINK_H
+
+#include <stdint.h>
+
+
+/* CABINET LINK
+ * ==========================================================================================
+ * Two cabinets joined by their hardware UARTs (LINK_SERIAL, crossed TX/RX and a common
+ * ground) play head-to-head: their games start at the same moment and each knows the
+ * other's score as it changes.
+ *
+ * Every message is a CobsFrame frame (lib/CobsFrame) holding [type u8] [body...]:
+ *
+ * Message        Body                                        Sent
+ * ------------------------------------------------------------------------------------------
+ * LINK_STATUS    id u32, t0 u32, state u8, score u8           every LINK_STATUS_MS and at
+ *                                                             once when state or score change
+ * LINK_ECHO      t0 u32, t1 u32                               in answer to a status
+ * LINK_START     at u32                                       by the leader, see below
+ *
+ * t0 is the sender's micros() and t1 the receiver's when it echoes. The sender takes
+ * rtt = now - t0 and offset = t1 - t0 - rtt / 2 (peer clock minus ours), and keeps the
+ * offset from the sample with the lowest RTT among the last LINK_SAMPLES: the one least
+ * disturbed by queueing.
+ *
+ * A game started with the link up waits in GS_START for the opponent, for up to
+ * LINK_JOIN_MS. Once both are in GS_START, the cabinet with the lower id (the leader)
+ * picks a start time GET_READY_DELAY_MS ahead on its clock and sends it, and both open
+ * their ball gates when their clocks reach it. If the opponent does not join in time, or
+ * the link drops, the game starts on its own as usual.
+ *
+ * linkPoll() does all the work in the caller's thread: it reads what the UART driver has
+ * buffered, answers and sends status, and never waits for the UART.
+ */
+
+#ifndef LINK_SERIAL
+#define LINK_SERIAL Serial1
+#endif
+#define LINK_BAUD 460800
+#define LINK_STATUS_MS 100    // status interval
+#define LINK_TIMEOUT_MS 500   // link down after this long without a message
+#define LINK_JOIN_MS 10000    // how long a game waits for the opponent
+#define LINK_SAMPLES 8        // clock offset samples kept
+#define LINK_RX_BUDGET 64     // bytes decoded per poll, at most
+
+enum LinkMessage {
+  LINK_STATUS = 1,
+  LINK_ECHO = 2,
+  LINK_START = 3,
+};
+
+typedef struct {
+  bool up;
+  bool headToHead;     // the current or last game was started with the opponent
+  uint8_t peerState;   // GameState
+  uint8_t peerScore;   // live during a game, final after it
+  int32_t offset;      // peer clock - ours, us
+  uint32_t rtt;        // of the sample the offset came from, us
+  uint32_t frames;     // good frames received
+  uint32_t errors;     // frames that failed the CRC
+} LinkStatus;
+
+void setupLink();
+void linkPoll();
+
+// GS_START: call on entry, then until it returns >= 0 (or the local deadline passes,
+// if it returns -1). 1 = start now, 0 = wait for the opponent, -1 = play alone.
+void linkStartBegin();
+int8_t linkStartCheck();
+
+void linkGetStatus(LinkStatus *out);
+
+
+#endif // LINK_H
@@ -0,0 +1,111 @@
+#include <Arduino.h>
+
+#include "memmap.h"
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#include <malloc.h>
+#endif
+
+
+#if defined(__arm__)
+
+#define MEMORY_FILL (0x01010101UL * THREADS_STACK_FILL)
+#define MEMORY_FILL_MARGIN 256 // bytes below the SP left alone by setupMemory()
+
+extern unsigned long _sdata, _edata, _sbss, _ebss, _estack;
+extern "C" char *__brkval; // heap break, from the core's _sbrk()
+
+static uint32_t heapPeak;
+
+static uint32_t mainSP() {
+  uint32_t sp;
+  __asm volatile("mrs %0, msp" : "=r"(sp));
+  return sp;
+}
+
+void setupMemory() {
+  uint32_t *p = (uint32_t *)(((uint32_t)__brkval + 3) & ~3);
+  uint32_t *end = (uint32_t *)(mainSP() - MEMORY_FILL_MARGIN);
+  while (p < end) *p++ = MEMORY_FILL;
+}
+
+// Lowest address the main stack has reached: the first word above the heap that lost its fill
+static uint32_t mainStackLow() {
+  const uint32_t *p = (const uint32_t *)(((uint32_t)__brkval + 3) & ~3);
+  const uint32_t *sp = (const uint32_t *)mainSP();
+  while (p < sp && *p == MEMORY_FILL) p++;
+  return (uint32_t)p;
+}
+
+bool memoryRegion(uint8_t region, MemoryUsage *out) {
+  uint32_t brk = (uint32_t)__brkval;
+  uint32_t top = (uint32_t)&_estack;
+
+  switch (region) {
+    case MEM_DATA:
+      out->start = (uint32_t)&_sdata;
+      out->size = out->used = out->peak = (uint32_t)&_edata - out->start;
+      return true;
+    case MEM_BSS:
+      out->start = (uint32_t)&_sbss;
+      out->size = out->used = out->peak = (uint32_t)&_ebss - out->start;
+      return true;
+    case MEM_HEAP:
+      out->start = (uint32_t)&_ebss;
+      out->size = brk - out->start;
+      out->used = mallinfo().uordblks;
+      if (out->size > heapPeak) heapPeak = out->size;
+      out->peak = heapPeak;
+      return true;
+    case MEM_STACK:
+      out->start = brk;
+      out->size = top - brk;
+      out->used = top - mainSP();
+      out->peak = top - mainStackLow();
+      return true;
+    default:
+      return false;
+  }
+}
+
+uint8_t memoryThreadCount() {
+  return Threads::MAX_THREADS;
+}
+
+bool memoryThread(uint8_t id, MemoryUsage *out, uint8_t *state) {
+  if (id >= Threads::MAX_THREADS) return false;
+  if (id == 0) {
+    *state = threads.getState(0);
+    return memoryRegion(MEM_STACK, out);
+  }
+
+  void *sp = 0;
+  uint8_t *stack = 0;
+  int size = 0;
+  *state = threads.getStackInfo(id, &sp, &stack, &size);
+  out->start = (uint32_t)stack;
+  out->size = size;
+  out->used = stack ? (uint32_t)(stack + size) - (uint32_t)sp : 0;
+  int peak = threads.getStackPeak(id);
+  out->peak = peak < 0 ? out->used : peak;
+  return true;
+}
+
+#else
+
+void setupMemory() {}
+
+bool memoryRegion(uint8_t, MemoryUsage *) {
+  return false;
+}
+
+uint8_t memoryThreadCount() {
+  return 0;
+}
+
+bool memoryThread(uint8_t, MemoryUsage *, uint8_t *) {
+  return false;
+}
+
+#endif // __arm__
@@ -0,0 +1,59 @@
+#ifndef MEMMAP_H
+#define MEMMAP_H
+
+#include <stdint.h>
+
+
+/* MEMORY MAP
+ * ==========================================================================================
+ * RAM use by region and by thread stack, from the linker symbols (_sdata, _edata, _sbss,
+ * _ebss, _estack), the core's heap break (__brkval) and TeensyThreads. Read over telemetry
+ * with hsctl memory.
+ *
+ * Region         start                 size                    used / peak
+ * ------------------------------------------------------------------------------------------
+ * MEM_DATA       _sdata                initialized statics     all of it
+ * MEM_BSS        _sbss                 zeroed statics          all of it (incl. pooled stacks)
+ * MEM_HEAP       _ebss                 heap break - _ebss      malloc'd bytes / largest break
+ * MEM_STACK      heap break            up to _estack           main stack depth now / deepest
+ *
+ * MEM_STACK is what the main stack (thread 0 and every ISR) can still grow into, so its
+ * size - peak is the RAM left. Peaks come from filling unused RAM and thread stacks with a
+ * known byte and finding how much of it has been overwritten: setupMemory() fills the free
+ * RAM below the main stack, and TeensyThreads fills stacks as it hands them out.
+ *
+ * On the host the figures are not available and every query returns false.
+ */
+
+enum MemoryRegion {
+  MEM_DATA,
+  MEM_BSS,
+  MEM_HEAP,
+  MEM_STACK,
+  MEM_REGION_COUNT
+};
+
+#define MEM_REGION_NAMES { "data", "bss", "heap", "stack" }
+
+typedef struct {
+  uint32_t start;
+  uint32_t size;
+  uint32_t used;
+  uint32_t peak;
+} MemoryUsage;
+
+// Fill free RAM for peak tracking, from the heap break (__brkval) to 256 bytes below the main
+// stack pointer. Call after setupThreads(): the thread stacks are live by then and sit in
+// .bss, and whatever setup took from the heap is below __brkval, so the fill touches nothing
+// in use.
+void setupMemory();
+
+bool memoryRegion(uint8_t region, MemoryUsage *out);
+
+// Stack of TeensyThreads thread 'id' (0 is the main stack); 'state' is the thread state.
+// Threads that have not been filled report a peak equal to their current use.
+bool memoryThread(uint8_t id, MemoryUsage *out, uint8_t *state);
+uint8_t memoryThreadCount();
+
+
+#endif // MEMMAP_H
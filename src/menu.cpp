@@ -0,0 +1,124 @@
+#include <Arduino.h>
+
+#include <AceButton.h>
+
+#include "menu.h"
+#include "config.h"
+#include "game.h"
+#include "pins.h"
+#include "selftest.h"
+#include "timebase.h"
+
+using namespace ace_button;
+
+
+#define BUTTON_AUX1 0
+#define BUTTON_AUX2 1
+#define BUTTON_RESET 2
+
+static const struct {
+  uint8_t field;
+  uint8_t min, max;
+} items[] = MENU_ITEMS;
+
+#define ITEM_COUNT (sizeof(items) / sizeof(items[0]))
+
+// The buttons time their debounce, clicks and holds on the firmware's time base. AceButton
+// keeps 16-bit copies internally, which is fine for intervals this short.
+class TimebaseButtonConfig : public ButtonConfig {
+public:
+  unsigned long getClock() override { return (unsigned long)timeMillis(); }
+  unsigned long getClockMicros() override { return (unsigned long)timeMicros(); }
+};
+
+static TimebaseButtonConfig buttonConfig;
+static AceButton aux1(&buttonConfig), aux2(&buttonConfig), reset(&buttonConfig);
+
+static volatile bool open;
+static uint8_t item;
+static uint64_t lastPressMillis;
+
+
+static void step(int8_t delta) {
+  int16_t v = configGet(items[item].field) + delta;
+  if (v < items[item].min) v = items[item].min;
+  if (v > items[item].max) v = items[item].max;
+  if (v == configGet(items[item].field)) return;
+  if (configApply(items[item].field, v)) applySetting(items[item].field);
+}
+
+static void onButton(AceButton *button, uint8_t event, uint8_t) {
+  uint8_t id = button->getId();
+  lastPressMillis = timeMillis();
+
+  if (id == BUTTON_RESET && event == AceButton::kEventLongPressed && !open) {
+    if (selfTestActive()) selfTestStop();
+    else selfTestStart();
+    return;
+  }
+  if (selfTestActive()) return; // every press is a test input
+
+  if (!open) {
+    if (id == BUTTON_AUX1 && event == AceButton::kEventLongPressed &&
+        curGameState == GameState::GS_ATTRACT && !delayNextGame) {
+      open = true;
+      item = 0;
+      Serial.println("Operator menu");
+    }
+    return;
+  }
+
+  switch (id) {
+    case BUTTON_AUX1:
+      if (event == AceButton::kEventClicked) item = (item + 1) % ITEM_COUNT;
+      else if (event == AceButton::kEventLongPressed) menuClose();
+      break;
+    case BUTTON_AUX2:
+    case BUTTON_RESET:
+      if (event == AceButton::kEventPressed || event == AceButton::kEventRepeatPressed) {
+        step(id == BUTTON_AUX2 ? 1 : -1);
+      }
+      break;
+  }
+}
+
+void setupMenu() {
+  buttonConfig.setEventHandler(onButton);
+  buttonConfig.setFeature(ButtonConfig::kFeatureClick);
+  buttonConfig.setFeature(ButtonConfig::kFeatureLongPress);
+  buttonConfig.setFeature(ButtonConfig::kFeatureRepeatPress);
+  buttonConfig.setFeature(ButtonConfig::kFeatureSuppressAfterLongPress);
+  buttonConfig.setLongPressDelay(MENU_HOLD_MS);
+  buttonConfig.setRepeatPressDelay(MENU_REPEAT_DELAY_MS);
+  buttonConfig.setRepeatPressInterval(MENU_REPEAT_MS);
+
+  // the pins are set up by setupIO()
+  aux1.init(AUX1_IN, HIGH, BUTTON_AUX1);
+  aux2.init(AUX2_IN, HIGH, BUTTON_AUX2);
+  reset.init(RESET_IN, HIGH, BUTTON_RESET);
+}
+
+void menuPoll() {
+  aux1.check();
+  aux2.check();
+  reset.check();
+  if (open && timeMillis() - lastPressMillis >= MENU_TIMEOUT_MS) menuClose();
+}
+
+bool menuActive() {
+  return open;
+}
+
+void menuClose() {
+  if (!open) return;
+  open = false;
+  Serial.println("Operator menu closed");
+}
+
+uint8_t menuItem() {
+  return item + 1;
+}
+
+uint8_t menuValue() {
+  return configGet(items[item].field);
+}
@@ -0,0 +1,52 @@
+#ifndef MENU_H
+#define MENU_H
+
+#include <stdint.h>
+
+
+/* OPERATOR MENU
+ * ==========================================================================================
+ * The programming buttons (AUX1, AUX2, RESET; pins.h) change the settings without a
+ * laptop or a reflash:
+ *
+ * Button     Press                      Menu open
+ * ------------------------------------------------------------------------------------------
+ * AUX1       hold MENU_HOLD_MS, idle     click: next setting; hold: close
+ *            in attract mode: open
+ * AUX2       -                          value up (hold to repeat)
+ * RESET      hold MENU_HOLD_MS: start    value down (hold to repeat)
+ *            or stop the self-test
+ *            (selftest.h)
+ *
+ * The menu also closes after MENU_TIMEOUT_MS without a press, and when a coin comes in.
+ * While it is open the TIME display shows "P" and the setting's number (MENU_ITEMS order)
+ * and the SCORE display its value.
+ *
+ * menuPoll() runs in the game thread and never waits: every change takes effect at once
+ * through configApply() and applySetting(), and the EEPROM catches up from loop()
+ * (configFlush), so neither a press nor closing the menu stalls anything.
+ */
+
+#define MENU_HOLD_MS 2000
+#define MENU_TIMEOUT_MS 30000
+#define MENU_REPEAT_DELAY_MS 500
+#define MENU_REPEAT_MS 100
+
+// Setting, lowest and highest value, in menu order
+#define MENU_ITEMS {                          \
+  { CFG_TICKETS_PER_SCORE, 1, 50 },           \
+  { CFG_PLAYS_PER_CREDIT, 1, 10 },            \
+  { CFG_PLAY_TIME, 5, 120 },                  \
+  { CFG_ATTRACT_TIME, 10, 255 },              \
+}
+
+void setupMenu();
+void menuPoll();
+
+bool menuActive();
+void menuClose();
+uint8_t menuItem();  // 1-based, for the display
+uint8_t menuValue();
+
+
+#endif // MENU_H
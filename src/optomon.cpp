@@ -0,0 +1,139 @@
+#include <Arduino.h>
+
+#include "optomon.h"
+
+
+static const char * const faultNames[] = OPTO_FAULT_NAMES;
+static const char * const optoNames[OPTO_COUNT] = { "upper", "lower" };
+
+static struct {
+  volatile bool blocked;
+  volatile uint32_t blockedSince; // millis()
+  volatile uint32_t edges;
+  volatile uint16_t windowEdges;  // since windowStart
+  volatile bool gameEdge;         // an edge since the game started
+  uint16_t rate;
+  uint8_t idleGames;
+  uint8_t faults;
+} optos[OPTO_COUNT];
+
+static uint32_t lastCheck, windowStart;
+static uint32_t heldMs; // game clock held by jams and chatter this game
+
+
+void optoMonitorEdge(uint8_t opto, bool blocked) {
+  if (opto >= OPTO_COUNT) return;
+  if (blocked && !optos[opto].blocked) optos[opto].blockedSince = millis();
+  optos[opto].blocked = blocked;
+  optos[opto].edges++;
+  optos[opto].windowEdges++;
+  optos[opto].gameEdge = true;
+}
+
+static void report(uint8_t opto, uint8_t was, uint8_t now) {
+  for (uint8_t bit = 0; bit < sizeof(faultNames) / sizeof(faultNames[0]); bit++) {
+    uint8_t mask = 1 << bit;
+    if ((was ^ now) & mask) {
+      Serial.print("Opto ");
+      Serial.print(optoNames[opto]);
+      Serial.print(now & mask ? " fault: " : " recovered: ");
+      Serial.println(faultNames[bit]);
+    }
+  }
+}
+
+void optoMonitorCheck(uint32_t now) {
+  uint32_t elapsed = now - lastCheck;
+  if (elapsed < OPTO_CHECK_MS) return;
+  lastCheck = now;
+
+  bool windowDone = now - windowStart >= OPTO_RATE_WINDOW_MS;
+  if (windowDone) windowStart = now;
+
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) {
+    uint8_t faults = optos[i].faults;
+
+    __disable_irq();
+    bool jammed = optos[i].blocked && now - optos[i].blockedSince >= OPTO_JAM_MS;
+    if (windowDone) {
+      optos[i].rate = optos[i].windowEdges;
+      optos[i].windowEdges = 0;
+    }
+    __enable_irq();
+
+    faults = jammed ? faults | OPTO_FAULT_JAM : faults & ~OPTO_FAULT_JAM;
+    if (windowDone) {
+      bool chatter = optos[i].rate > OPTO_CHATTER_EDGES;
+      faults = chatter ? faults | OPTO_FAULT_CHATTER : faults & ~OPTO_FAULT_CHATTER;
+    }
+    if (optos[i].gameEdge) { // any edge revives a dead beam
+      optos[i].idleGames = 0;
+      faults &= ~OPTO_FAULT_DEAD;
+    }
+    if (!(faults & (OPTO_FAULT_JAM | OPTO_FAULT_CHATTER))) faults &= ~OPTO_FAULT_HELD;
+
+    if (faults != optos[i].faults) {
+      report(i, optos[i].faults, faults);
+      optos[i].faults = faults;
+    }
+  }
+
+  // past the limit, the beams holding the clock are marked held and it runs on
+  if (!optoHoldGame()) return;
+  heldMs += elapsed;
+  if (heldMs < OPTO_HOLD_MAX_MS) return;
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) {
+    if (!(optos[i].faults & (OPTO_FAULT_JAM | OPTO_FAULT_CHATTER))) continue;
+    report(i, optos[i].faults, optos[i].faults | OPTO_FAULT_HELD);
+    optos[i].faults |= OPTO_FAULT_HELD;
+  }
+}
+
+void optoMonitorGameStart() {
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) optos[i].gameEdge = false;
+  heldMs = 0;
+}
+
+void optoMonitorGameEnd() {
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) {
+    if (optos[i].gameEdge) {
+      optos[i].idleGames = 0;
+      continue;
+    }
+    if (optos[i].idleGames < 255) optos[i].idleGames++;
+    if (optos[i].idleGames >= OPTO_DEAD_GAMES && !(optos[i].faults & OPTO_FAULT_DEAD)) {
+      report(i, optos[i].faults, optos[i].faults | OPTO_FAULT_DEAD);
+      optos[i].faults |= OPTO_FAULT_DEAD;
+    }
+  }
+}
+
+uint8_t optoFaults(uint8_t opto) {
+  return opto < OPTO_COUNT ? optos[opto].faults : 0;
+}
+
+uint8_t optoFaultsAny() {
+  return optos[0].faults | optos[1].faults;
+}
+
+bool optoHoldGame() {
+  uint8_t faults = optoFaultsAny();
+  return (faults & (OPTO_FAULT_JAM | OPTO_FAULT_CHATTER)) && !(faults & OPTO_FAULT_HELD);
+}
+
+bool optoHoldScoring() {
+  return optoFaultsAny() & (OPTO_FAULT_JAM | OPTO_FAULT_CHATTER);
+}
+
+bool optoStatus(uint8_t opto, OptoStatus *out) {
+  if (opto >= OPTO_COUNT) return false;
+  __disable_irq();
+  out->blocked = optos[opto].blocked;
+  out->blockedMs = out->blocked ? millis() - optos[opto].blockedSince : 0;
+  out->edges = optos[opto].edges;
+  __enable_irq();
+  out->faults = optos[opto].faults;
+  out->rate = optos[opto].rate;
+  out->idleGames = optos[opto].idleGames;
+  return true;
+}
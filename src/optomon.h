@@ -0,0 +1,75 @@
+#ifndef OPTOMON_H
+#define OPTOMON_H
+
+#include <stdint.h>
+
+
+/* OPTO MONITOR
+ * ==========================================================================================
+ * Watches both opto beams for the faults that would otherwise make the game stop scoring,
+ * or score by itself, without anyone noticing:
+ *
+ * Fault                Raised when                                   Cleared when
+ * ------------------------------------------------------------------------------------------
+ * OPTO_FAULT_JAM       the beam stays blocked OPTO_JAM_MS (a ball     the beam clears
+ *                      stuck in the net)
+ * OPTO_FAULT_CHATTER   more than OPTO_CHATTER_EDGES edges in one      a window at or below it
+ *                      OPTO_RATE_WINDOW_MS window (dirty or loose
+ *                      sensor; a ball makes two)
+ * OPTO_FAULT_DEAD      no edges at all in OPTO_DEAD_GAMES games in    the next edge
+ *                      a row (sensor or harness gone)
+ * OPTO_FAULT_HELD      a jam or chatter has held the game clock       its jam and chatter clear
+ *                      OPTO_HOLD_MAX_MS in one game (failed sensor)
+ *
+ * The opto ISRs report every edge (constant time); optoMonitorCheck() does the rest from
+ * the game thread every OPTO_CHECK_MS. While a beam is jammed or chattering the game holds
+ * its clock and scores nothing, so the player neither loses time nor gets free points; a
+ * dead beam only asks for maintenance. The hold lasts OPTO_HOLD_MAX_MS per game at most:
+ * a beam that has failed blocked or chatters for good is then marked held and the clock
+ * runs on, still without scoring, so the game ends, pays its tickets and lets the queued
+ * credits play. Changes are logged, streamed as TM_EV_FAULT and shown by hsctl optos, and
+ * the status LED blinks fast while any fault is active.
+ */
+
+#define OPTO_CHECK_MS 100
+#define OPTO_JAM_MS 2000
+#define OPTO_RATE_WINDOW_MS 1000
+#define OPTO_CHATTER_EDGES 20
+#define OPTO_DEAD_GAMES 3
+#define OPTO_HOLD_MAX_MS 30000 // game clock held per game, at most
+
+#define OPTO_COUNT 2 // OPTO_UPPER, OPTO_LOWER
+
+#define OPTO_FAULT_JAM 0x01
+#define OPTO_FAULT_CHATTER 0x02
+#define OPTO_FAULT_DEAD 0x04
+#define OPTO_FAULT_HELD 0x08
+
+#define OPTO_FAULT_NAMES { "jam", "chatter", "dead", "held" }
+
+typedef struct {
+  bool blocked;
+  uint8_t faults;        // OPTO_FAULT_*
+  uint32_t blockedMs;    // how long it has been blocked, 0 if clear
+  uint32_t edges;        // since boot
+  uint16_t rate;         // edges in the last full window
+  uint8_t idleGames;     // games in a row without an edge
+} OptoStatus;
+
+// From the opto ISRs, for every edge; 'blocked' is the level after it
+void optoMonitorEdge(uint8_t opto, bool blocked);
+// From the game thread; runs the checks every OPTO_CHECK_MS
+void optoMonitorCheck(uint32_t now);
+void optoMonitorGameStart();
+void optoMonitorGameEnd();
+
+uint8_t optoFaults(uint8_t opto);
+uint8_t optoFaultsAny();  // both optos or-ed together
+// A jam or chatter that the game clock waits for, until OPTO_HOLD_MAX_MS
+bool optoHoldGame();
+// A jam or chatter, held or not: no shot scores meanwhile
+bool optoHoldScoring();
+bool optoStatus(uint8_t opto, OptoStatus *out);
+
+
+#endif // OPTOMON_H
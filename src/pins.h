@@ -0,0 +1,89 @@
+#ifndef PINS_H
+#define PINS_H
+
+
+/* INPUTS
+ * ==========================================================================================
+ * UPPER/LOWER Opto - abstractify
+ *    optos are 12vdc
+ *    each is 3pin, +12V, SENSE, GND
+ *    harness connector has 4pin, +12V, UPPER_SENSE, LOWER_SENSE, GND
+ *    On Connector P2, LOWER_SENSE = 9, UPPER_SENSE = 8
+ *
+ * COIN 1/2
+ *    simple rising edge interrupt, maybe 12v?
+ *    On Connector P2, COIN1 = 1, COIN2 = 2
+ *
+ * AUX1/AUX2/RESET programming buttons
+ *    simple debounce. interrupt on RESET and AUX1 (to enter programming mode)
+ *
+ * SUPPLY SENSE
+ *    +12V through a 47k/10k divider to an ADC1 pin, about 2.1V at 12V (see supply.h)
+ */
+
+#define UPPER_OPTO_IN 2
+#define LOWER_OPTO_IN 3
+#define OPTO_BLOCKED HIGH // sense level while a ball is in the beam
+
+#define COIN1_IN 4
+
+#define AUX1_IN 5
+#define AUX2_IN 6
+#define RESET_IN 7
+
+#define SUPPLY_SENSE_IN A12 // ADC1 only
+
+/* OUTPUTS
+ * ==========================================================================================
+ * TICKET/CREDIT counters
+ *    5v counter, ticks on rising edge.
+ *    Same harness as AUX1/AUX2/RESET
+ *    On Connector P3, TICKET_COUNTER = 1, COIN_COUNTER = 2
+ *
+* TICKET_NOTCH
+ *    active low, pulse at 1ms intervals for however many tickets to dispense
+ *    Connect directly to TeensyMainBoard
+ *
+ * BALL GATE ACTUATOR
+ *    active high, hold for gate open.
+ *    runs through transistor to drive relay coil
+ *
+ *
+ * STATUS LED
+ *    using LED_BUILTIN
+ *
+ * CREDIT LED
+ *    ??
+ */
+
+#define TICKET_COUNTER_OUT 14
+#define CREDIT_COUNTER_OUT 15
+#define TICKET_NOTCH_OUT 16
+#define BALL_GATE_OUT 17
+
+#define STATUS_LED LED_BUILTIN
+#define STATUS_BLINK_MS 60
+#define STATUS_BLINK_DELAY_MS 1000
+#define STATUS_FAULT_BLINK_MS 150 // steady fast blink: an opto needs attention (optomon.h)
+
+
+/* INTERFACES
+ * ==========================================================================================
+ * 7Seg TIME/SCORE displays
+ *    use 2 MAX7219s, one per display
+ *    https://www.ebay.com/itm/MAXIM-MAX7219CNG-DIP-24-LED-Display-Driver-IC-NEW-C/141975802299
+ */
+
+#define DISPLAY_ENABLE_OUT 23
+#define DISPLAY_STROBE_OUT 22
+#define DISPLAY_SDATA_OUT 21
+#define DISPLAY_CLOCK_OUT 20
+
+/*
+ * CABINET LINK (see link.h)
+ *    Serial1: RX1 = 0, TX1 = 1, 3.3V levels
+ *    cross TX/RX to the other cabinet and join the grounds
+ */
+
+
+#endif // PINS_H
@@ -0,0 +1,16 @@
+#include <Arduino.h>
+
+#include "probes.h"
+
+
+void setupProbes() {
+  probe_init();
+  probe_name(PROBE_SCHEDULER, "scheduler");
+  probe_name(PROBE_COIN_ISR, "coin1ISR");
+  probe_name(PROBE_OPTO_ISR, "optoISR");
+  probe_name(PROBE_GAME_TIMER, "gameTimer");
+  probe_name(PROBE_DISPENSE, "dispense");
+  probe_name(PROBE_DISPLAY, "display");
+  probe_name(PROBE_GAME_UPDATE, "gameUpdate");
+  probe_name(PROBE_LINK, "linkPoll");
+}
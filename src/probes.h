@@ -0,0 +1,26 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+#include <Probe.h>
+
+
+/* PROBES
+ * ==========================================================================================
+ * Timing probes on the firmware's hot paths (see lib/Probe). Compiled in
+ * only when PROBE_ENABLE is defined (HOTSHOT_PROBES in the CMake build).
+ */
+
+enum {
+  PROBE_COIN_ISR = PROBE_USER,  // coin1ISR
+  PROBE_OPTO_ISR,               // upperOptoISR, lowerOptoISR (scoring and shot analytics)
+  PROBE_GAME_TIMER,             // gameTimerCallback
+  PROBE_DISPENSE,               // ticket payout pulse servicing
+  PROBE_DISPLAY,                // one displayUpdate()
+  PROBE_GAME_UPDATE,            // one pass of the game state machine
+  PROBE_LINK,                   // one linkPoll()
+};
+
+void setupProbes();
+
+
+#endif // PROBES_H
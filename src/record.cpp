@@ -0,0 +1,97 @@
+#include <Arduino.h>
+
+#include "record.h"
+#include "config.h"
+#include "game.h"
+#include "timebase.h"
+
+
+static RecordEvent ring[RECORD_SIZE];
+static volatile uint32_t count;
+static volatile bool replaying;
+
+static const char * const typeNames[REC_TYPE_COUNT] = REC_TYPE_NAMES;
+
+
+void recordEvent(uint8_t type, uint8_t id, uint16_t value) {
+  uint32_t now = (uint32_t)timeMicros();
+  __disable_irq();
+  RecordEvent &e = ring[count % RECORD_SIZE];
+  e.micros = now;
+  e.type = type;
+  e.id = id;
+  e.value = value;
+  count++;
+  __enable_irq();
+}
+
+void setupRecord() {
+  recordEvent(REC_BOOT, 0, 0);
+  for (uint8_t i = 0; i < CFG_COUNT; i++) {
+    recordEvent(REC_CONFIG, i, configGet(i));
+  }
+}
+
+uint32_t recordCount() {
+  return count;
+}
+
+uint32_t recordFirst() {
+  uint32_t n = count;
+  return n > RECORD_SIZE ? n - RECORD_SIZE : 0;
+}
+
+bool recordGet(uint32_t index, RecordEvent *out) {
+  __disable_irq();
+  bool ok = index < count && count - index <= RECORD_SIZE;
+  if (ok) *out = ring[index % RECORD_SIZE];
+  __enable_irq();
+  return ok;
+}
+
+const char *recordTypeName(uint8_t type) {
+  return type < REC_TYPE_COUNT ? typeNames[type] : "?";
+}
+
+bool replayMode() {
+  return replaying;
+}
+
+bool replaySetMode(bool enable) {
+  if (enable && !replaying && !gameIdle()) return false;
+  if (enable && !replaying) {
+    while (configFlush()); // queued settings go out before they can take replayed values
+  }
+  if (!enable && replaying) {
+    uint8_t changed = configReload(); // back to the cabinet's own settings
+    for (uint8_t i = 0; i < CFG_COUNT; i++) {
+      if (changed & (1 << i)) applySetting(i);
+    }
+  }
+  replaying = enable;
+  return true;
+}
+
+bool recordInject(uint8_t type, uint8_t id, uint16_t value) {
+  if (!replaying) return false;
+
+  switch (type) {
+    case REC_CONFIG:
+      if (!configApply(id, value)) return false; // RAM only while replaying (config.h)
+      applySetting(id);
+      return true;
+    case REC_COIN:
+      __disable_irq();
+      coinInput();
+      __enable_irq();
+      return true;
+    case REC_OPTO:
+      if (id > OPTO_LOWER) return false;
+      __disable_irq();
+      optoInput(id, value);
+      __enable_irq();
+      return true;
+    default:
+      return false; // boot, ticks and states are not inputs
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdint.h>
+
+
+/* INPUT RECORDER
+ * ==========================================================================================
+ * Every external input the game reacts to is appended, with its micros() timestamp, to a
+ * RAM ring, together with the state transitions it caused. The ring can be read out over
+ * telemetry (hsctl record) and fed back to the game engine, either on the host
+ * (hotshot-replay, in virtual time) or on a cabinet in replay mode (hsctl replay), where
+ * the physical inputs are ignored and recorded ones are injected instead.
+ *
+ * Type           id                  value
+ * ------------------------------------------------------------------------------------------
+ * REC_BOOT       0                   0                       start of a recording
+ * REC_CONFIG     ConfigField         setting value           at boot and on every change
+ * REC_COIN       coin mech (0)       1                       a coin was seen (rising edge)
+ * REC_OPTO       OPTO_UPPER/LOWER    pin level after edge
+ * REC_TICK       REC_GAME/ATTRACT    seconds left (game)     an IntervalTimer fired
+ * REC_STATE      GameState entered   current score           result, used to check replays
+ *
+ * REC_BOOT, REC_CONFIG, REC_COIN and REC_OPTO are inputs; REC_TICK and REC_STATE are what
+ * a faithful replay must reproduce.
+ */
+
+#ifndef RECORD_SIZE
+#define RECORD_SIZE 1024 // events kept, 8 bytes each
+#endif
+
+#define RECORD_TEXT_HEADER "# hotshot record v1"
+
+enum RecordType {
+  REC_BOOT,
+  REC_CONFIG,
+  REC_COIN,
+  REC_OPTO,
+  REC_TICK,
+  REC_STATE,
+  REC_TYPE_COUNT
+};
+
+#define REC_TYPE_NAMES { "boot", "config", "coin", "opto", "tick", "state" }
+
+#define REC_GAME 0
+#define REC_ATTRACT 1
+
+typedef struct {
+  uint32_t micros;
+  uint8_t type;
+  uint8_t id;
+  uint16_t value;
+} RecordEvent;
+
+// Start a recording: marks boot and logs the current settings
+void setupRecord();
+
+// Append an event; safe from ISRs
+void recordEvent(uint8_t type, uint8_t id, uint16_t value);
+
+// Events recorded since boot; the ring holds the last RECORD_SIZE of them
+uint32_t recordCount();
+// Oldest index still in the ring
+uint32_t recordFirst();
+// Copy event 'index' (counting from boot); false if it was overwritten or not written yet
+bool recordGet(uint32_t index, RecordEvent *out);
+
+const char *recordTypeName(uint8_t type);
+
+/*
+ * Replay mode: physical inputs are ignored and recordInject() feeds the game instead,
+ * through the same handlers the ISRs use. Only entered while the cabinet is idle. Settings
+ * changed during a replay stay in RAM and the stored ones return when it ends (config.h).
+ */
+bool replayMode();
+bool replaySetMode(bool enable);
+bool recordInject(uint8_t type, uint8_t id, uint16_t value);
+
+
+#endif // RECORD_H
@@ -0,0 +1,191 @@
+#include <Arduino.h>
+
+#include <BlockPool.h>
+#include <Mailbox.h>
+
+#include "selftest.h"
+#include "game.h"
+#include "irq.h"
+#include "pins.h"
+#include "timebase.h"
+
+
+static const char * const inputNames[SELFTEST_INPUT_COUNT] = SELFTEST_INPUT_NAMES;
+static const char * const stepNames[SELFTEST_STEP_COUNT] = { "ball gate", "ticket", "credit counter", "displays" };
+
+static volatile bool active;
+
+// an edge captured by an ISR, on its way to selfTestPoll()
+typedef struct {
+  uint64_t micros;
+  uint8_t input;
+  bool active;
+} SelfTestEdge;
+
+BLOCK_POOL(edgePool, "self-test", sizeof(SelfTestEdge), SELFTEST_QUEUE);
+MAILBOX(edgeBox, "self-test", SELFTEST_QUEUE);
+static volatile uint32_t edgesDropped;
+
+static SelfTestLatency latency[SELFTEST_INPUT_COUNT];
+static bool haveLast;
+static uint8_t lastInput;
+static bool lastActive;
+
+static uint8_t step;
+static uint32_t stepStartMillis;
+static int8_t pulsePin = -1;
+
+
+void selfTestCapture(uint8_t input, bool isActive) {
+  uint64_t now = timeMicros();
+  SelfTestEdge *e = edgePool.create<SelfTestEdge>();
+  if (!e) {
+    edgesDropped++;
+    return;
+  }
+  e->micros = now;
+  e->input = input;
+  e->active = isActive;
+  edgeBox.post(e); // as deep as the pool, so never full
+}
+
+static void aux1ISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTD);
+  selfTestCapture(SELFTEST_IN_AUX1, digitalReadFast(AUX1_IN) == LOW);
+}
+
+static void aux2ISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTD);
+  selfTestCapture(SELFTEST_IN_AUX2, digitalReadFast(AUX2_IN) == LOW);
+}
+
+static void resetISR() {
+  IRQ_SCOPE(IRQ_SRC_PORTD);
+  selfTestCapture(SELFTEST_IN_RESET, digitalReadFast(RESET_IN) == LOW);
+}
+
+static void beginStep(uint32_t now) {
+  stepStartMillis = now;
+  Serial.print("Self-test: ");
+  Serial.println(stepNames[step]);
+  switch (step) {
+    case SELFTEST_GATE: pulsePin = BALL_GATE_OUT; break;
+    case SELFTEST_CREDIT: pulsePin = CREDIT_COUNTER_OUT; break;
+    case SELFTEST_TICKET: dispenseTickets(1); break;
+  }
+  if (pulsePin >= 0) digitalWriteFast(pulsePin, HIGH);
+}
+
+static void endPulse() {
+  if (pulsePin < 0) return;
+  digitalWriteFast(pulsePin, LOW);
+  pulsePin = -1;
+}
+
+bool selfTestStart() {
+  if (active) return true;
+  if (!gameIdle()) return false;
+
+  memset(latency, 0, sizeof(latency));
+  while (SelfTestEdge *e = edgeBox.tryReceive<SelfTestEdge>()) edgePool.destroy(e); // from the last run
+  edgesDropped = 0;
+  haveLast = false;
+  Serial.println("Self-test started");
+
+  active = true;
+  attachInterrupt(digitalPinToInterrupt(AUX1_IN), aux1ISR, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(AUX2_IN), aux2ISR, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(RESET_IN), resetISR, CHANGE);
+
+  step = 0;
+  beginStep(millis());
+  return true;
+}
+
+void selfTestStop() {
+  if (!active) return;
+  detachInterrupt(digitalPinToInterrupt(AUX1_IN));
+  detachInterrupt(digitalPinToInterrupt(AUX2_IN));
+  detachInterrupt(digitalPinToInterrupt(RESET_IN));
+  active = false;
+  endPulse();
+
+  Serial.println("Self-test results: input, edges, latency min/avg/max us");
+  for (uint8_t i = 0; i < SELFTEST_INPUT_COUNT; i++) {
+    const SelfTestLatency *l = &latency[i];
+    Serial.print("  ");
+    Serial.print(inputNames[i]);
+    Serial.print(": ");
+    Serial.print(l->count);
+    if (l->count) {
+      Serial.print(", ");
+      Serial.print(l->minUs);
+      Serial.print('/');
+      Serial.print((uint32_t)(l->sumUs / l->count));
+      Serial.print('/');
+      Serial.print(l->maxUs);
+    }
+    Serial.println();
+  }
+  if (edgesDropped) {
+    Serial.print("  edges dropped: ");
+    Serial.println(edgesDropped);
+  }
+}
+
+bool selfTestActive() {
+  return active;
+}
+
+void selfTestPoll() {
+  if (!active) return;
+
+  while (SelfTestEdge *e = edgeBox.tryReceive<SelfTestEdge>()) {
+    uint32_t us = (uint32_t)(timeMicros() - e->micros);
+    uint8_t input = e->input;
+    bool isActive = e->active;
+    edgePool.destroy(e);
+    if (input >= SELFTEST_INPUT_COUNT) continue;
+
+    SelfTestLatency *l = &latency[input];
+    if (!l->count || us < l->minUs) l->minUs = us;
+    if (us > l->maxUs) l->maxUs = us;
+    l->lastUs = us;
+    l->sumUs += us;
+    l->count++;
+    haveLast = true;
+    lastInput = input;
+    lastActive = isActive;
+
+    Serial.print("Self-test: ");
+    Serial.print(inputNames[input]);
+    Serial.print(isActive ? " on, " : " off, ");
+    Serial.print(us);
+    Serial.println(" us");
+  }
+
+  uint32_t now = millis();
+  if (now - stepStartMillis >= SELFTEST_PULSE_MS) endPulse();
+  if (now - stepStartMillis >= SELFTEST_STEP_MS) {
+    step = (step + 1) % SELFTEST_STEP_COUNT;
+    beginStep(now);
+  }
+}
+
+uint8_t selfTestStep() {
+  return step;
+}
+
+bool selfTestLatency(uint8_t input, SelfTestLatency *out) {
+  if (input >= SELFTEST_INPUT_COUNT) return false;
+  *out = latency[input];
+  return true;
+}
+
+bool selfTestLast(uint8_t *input, bool *isActive, uint32_t *latencyUs) {
+  if (!haveLast) return false;
+  *input = lastInput;
+  *isActive = lastActive;
+  *latencyUs = latency[lastInput].lastUs;
+  return true;
+}
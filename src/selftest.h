@@ -0,0 +1,78 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <stdint.h>
+
+
+/* SELF-TEST
+ * ==========================================================================================
+ * A field check of every output and input without a meter. Hold RESET for MENU_HOLD_MS
+ * while the cabinet is idle in attract mode (or run hsctl selftest start) to begin; the
+ * same again stops it and prints the results.
+ *
+ * Outputs   one step every SELFTEST_STEP_MS, round and round: ball gate (pulsed
+ *           SELFTEST_PULSE_MS), one ticket (notch and ticket counter), credit counter
+ *           (pulsed), every display segment lit.
+ * Inputs    each edge on the optos, coin and buttons is time-stamped by its ISR (the
+ *           capture) and posted through a mailbox (lib/Mailbox) to selfTestPoll() in the
+ *           game thread (the handler), which logs it and shows it: SCORE = the input's
+ *           number (SelfTestInput + 1), with the decimal point lit while it is active;
+ *           TIME = its latency.
+ *
+ * The latency is handler time minus capture time, in us: how long an input waits before
+ * the software acts on it, which is where a starved thread or a slow path shows up. The
+ * port interrupts on these pins do not capture edge times in hardware, so the capture
+ * is the ISR's first timeMicros(). Count, last, min, max and sum are kept per input.
+ *
+ * While the self-test runs, coins credit nothing and the optos score nothing.
+ */
+
+#define SELFTEST_STEP_MS 1500
+#define SELFTEST_PULSE_MS 300
+#define SELFTEST_QUEUE 16 // edges waiting for the handler, at most (pool and mailbox)
+
+enum SelfTestInput {
+  SELFTEST_IN_UPPER,
+  SELFTEST_IN_LOWER,
+  SELFTEST_IN_COIN,
+  SELFTEST_IN_AUX1,
+  SELFTEST_IN_AUX2,
+  SELFTEST_IN_RESET,
+  SELFTEST_INPUT_COUNT
+};
+
+#define SELFTEST_INPUT_NAMES { "upper", "lower", "coin", "aux1", "aux2", "reset" }
+
+enum SelfTestStep {
+  SELFTEST_GATE,
+  SELFTEST_TICKET,
+  SELFTEST_CREDIT,
+  SELFTEST_DISPLAYS,
+  SELFTEST_STEP_COUNT
+};
+
+typedef struct {
+  uint32_t count;
+  uint32_t lastUs;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+} SelfTestLatency;
+
+// Start only when the game is idle; false otherwise
+bool selfTestStart();
+void selfTestStop();
+bool selfTestActive();
+
+// From the ISRs while active: 'active' is whether the input is now blocked or pressed
+void selfTestCapture(uint8_t input, bool active);
+// From the game thread
+void selfTestPoll();
+
+uint8_t selfTestStep();
+bool selfTestLatency(uint8_t input, SelfTestLatency *out);
+// The input and latency to show; false before the first edge
+bool selfTestLast(uint8_t *input, bool *active, uint32_t *latencyUs);
+
+
+#endif // SELFTEST_H
@@ -0,0 +1,85 @@
+#include <Arduino.h>
+
+#include "shots.h"
+
+
+static ShotSummary summary[SHOTS_KIND_COUNT];
+static uint16_t streak;
+
+// rolling distribution: the bucket of each of the last SHOT_WINDOW transits, and counts
+static uint8_t window[SHOT_WINDOW];
+static uint8_t windowNext, windowFill;
+static uint8_t bucketCount[SHOT_BUCKETS];
+
+
+static void fold(ShotSummary *into, const ShotSummary *game) {
+  if (game->baskets) {
+    if (!into->baskets || game->minUs < into->minUs) into->minUs = game->minUs;
+    if (game->maxUs > into->maxUs) into->maxUs = game->maxUs;
+  }
+  into->baskets += game->baskets;
+  into->misses += game->misses;
+  into->swishes += game->swishes;
+  into->sumUs += game->sumUs;
+  if (game->bestStreak > into->bestStreak) into->bestStreak = game->bestStreak;
+}
+
+void shotsBeginGame() {
+  memset(&summary[SHOTS_GAME], 0, sizeof(ShotSummary));
+  streak = 0;
+}
+
+void shotsEndGame() {
+  summary[SHOTS_LAST] = summary[SHOTS_GAME];
+  fold(&summary[SHOTS_LIFETIME], &summary[SHOTS_GAME]);
+}
+
+uint8_t shotScored(uint32_t transitUs) {
+  ShotSummary *g = &summary[SHOTS_GAME];
+  if (!g->baskets || transitUs < g->minUs) g->minUs = transitUs;
+  if (transitUs > g->maxUs) g->maxUs = transitUs;
+  g->sumUs += transitUs;
+  g->baskets++;
+  if (++streak > g->bestStreak) g->bestStreak = streak;
+
+  uint32_t b = transitUs / SHOT_BUCKET_US;
+  if (b >= SHOT_BUCKETS) b = SHOT_BUCKETS - 1;
+  if (windowFill == SHOT_WINDOW) bucketCount[window[windowNext]]--;
+  else windowFill++;
+  window[windowNext] = b;
+  windowNext = (windowNext + 1) % SHOT_WINDOW;
+  bucketCount[b]++;
+
+  uint8_t bonus = 0;
+  if (transitUs < SHOT_SWISH_MAX_US) {
+    g->swishes++;
+    bonus += SHOT_SWISH_BONUS;
+  }
+  if (streak >= SHOT_STREAK_LEN) bonus += SHOT_STREAK_BONUS;
+  return bonus;
+}
+
+void shotMissed() {
+  summary[SHOTS_GAME].misses++;
+  streak = 0;
+}
+
+bool shotsSummary(uint8_t kind, ShotSummary *out) {
+  if (kind >= SHOTS_KIND_COUNT) return false;
+  __disable_irq();
+  *out = summary[kind];
+  __enable_irq();
+  return true;
+}
+
+uint16_t shotStreak() {
+  return streak;
+}
+
+uint8_t shotsDistribution(uint8_t *counts) {
+  __disable_irq();
+  memcpy(counts, bucketCount, sizeof(bucketCount));
+  uint8_t n = windowFill;
+  __enable_irq();
+  return n;
+}
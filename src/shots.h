@@ -0,0 +1,72 @@
+#ifndef SHOTS_H
+#define SHOTS_H
+
+#include <stdint.h>
+
+
+/* SHOT ANALYTICS
+ * ==========================================================================================
+ * A basket is the ball breaking the upper beam, then the lower one within SCORE_WINDOW_MS.
+ * The time between the two (the transit) tells how it went in: a clean swish drops
+ * straight through, a rim roll-in dawdles. A ball that breaks the upper beam and never
+ * reaches the lower one in time is a miss.
+ *
+ * The opto ISRs report each shot here. Every update is a few integer operations with no
+ * loops, so scoring costs the same whatever has been recorded:
+ *  - a summary of the game in progress (baskets, misses, swishes, transit min/max/sum,
+ *    longest streak of baskets without a miss), folded into the last-game and lifetime
+ *    (since boot) summaries when the game ends;
+ *  - a rolling distribution of the last SHOT_WINDOW transits, in SHOT_BUCKETS buckets of
+ *    SHOT_BUCKET_US (the last one takes everything slower), across games;
+ *  - the current streak, which can earn bonus points.
+ *
+ * Bonus rules are off unless their points are set at build time: SHOT_SWISH_BONUS for
+ * every swish, SHOT_STREAK_BONUS for every basket from the SHOT_STREAK_LEN'th in a row on.
+ * Read the summaries with hsctl shots.
+ */
+
+#define SHOT_SWISH_MAX_US 90000UL // transits faster than this are swishes; tune per cabinet
+#define SHOT_BUCKET_US 25000UL
+#define SHOT_BUCKETS 16
+#define SHOT_WINDOW 32            // transits in the rolling distribution (a power of two)
+
+#ifndef SHOT_SWISH_BONUS
+#define SHOT_SWISH_BONUS 0
+#endif
+#ifndef SHOT_STREAK_BONUS
+#define SHOT_STREAK_BONUS 0
+#endif
+#define SHOT_STREAK_LEN 3
+
+enum ShotSummaryKind {
+  SHOTS_GAME,       // the game in progress (or the last one, between games)
+  SHOTS_LAST,       // the last finished game
+  SHOTS_LIFETIME,   // every game since boot
+  SHOTS_KIND_COUNT
+};
+
+typedef struct {
+  uint16_t baskets;
+  uint16_t misses;
+  uint16_t swishes;
+  uint16_t bestStreak;
+  uint32_t minUs;    // transit times of the baskets; min is 0 until there is one
+  uint32_t maxUs;
+  uint64_t sumUs;
+} ShotSummary;
+
+// Game flow: a new summary when the ball gate opens, folded in when it closes
+void shotsBeginGame();
+void shotsEndGame();
+
+// From the opto ISRs, during a game. shotScored() returns the bonus points earned.
+uint8_t shotScored(uint32_t transitUs);
+void shotMissed();
+
+bool shotsSummary(uint8_t kind, ShotSummary *out);
+uint16_t shotStreak();
+// The rolling distribution: SHOT_BUCKETS counts; returns the number of transits in it
+uint8_t shotsDistribution(uint8_t *counts);
+
+
+#endif // SHOTS_H
@@ -0,0 +1,41 @@
+#include <Arduino.h>
+
+#include <FastPin.h>
+
+#include "statusled.h"
+#include "optomon.h"
+#include "pins.h"
+
+
+typedef Pin<STATUS_LED> StatusLed;
+
+// Phase lengths in ms, starting with the LED on and alternating
+static const uint16_t normalBlink[] = { STATUS_BLINK_MS, STATUS_BLINK_MS, STATUS_BLINK_MS, STATUS_BLINK_DELAY_MS };
+static const uint16_t faultBlink[] = { STATUS_FAULT_BLINK_MS, STATUS_FAULT_BLINK_MS };
+
+static const uint16_t *pattern = normalBlink;
+static uint8_t phases = sizeof(normalBlink) / sizeof(normalBlink[0]);
+static uint8_t phase;
+static uint32_t phaseEndMillis;
+
+
+void setupStatusLed() {
+  StatusLed::low();
+  phase = 0;
+  phaseEndMillis = millis();
+}
+
+uint32_t statusLedUpdate(uint32_t now) {
+  if ((int32_t)(now - phaseEndMillis) < 0) return phaseEndMillis - now;
+
+  if (phase == 0) {
+    bool fault = optoFaultsAny();
+    pattern = fault ? faultBlink : normalBlink;
+    phases = fault ? sizeof(faultBlink) / sizeof(faultBlink[0]) : sizeof(normalBlink) / sizeof(normalBlink[0]);
+  }
+  uint16_t ms = pattern[phase];
+  StatusLed::write(phase % 2 == 0);
+  phaseEndMillis = now + ms;
+  phase = (phase + 1) % phases;
+  return ms;
+}
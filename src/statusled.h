@@ -0,0 +1,22 @@
+#ifndef STATUSLED_H
+#define STATUSLED_H
+
+#include <stdint.h>
+
+
+/* STATUS LED
+ * ==========================================================================================
+ * A double blink every STATUS_BLINK_DELAY_MS while all is well; a steady fast blink
+ * (STATUS_FAULT_BLINK_MS) while an opto needs attention (optomon.h). The pattern is picked
+ * at the start of each cycle. Timings are in pins.h.
+ *
+ * statusLedUpdate() never waits: it moves the LED on when the current phase is over and
+ * returns how long until the next change, so the status thread sleeps that long and the
+ * cyclic executive (cyclic.h) just calls it on schedule.
+ */
+
+void setupStatusLed();
+uint32_t statusLedUpdate(uint32_t now); // ms until the next change
+
+
+#endif // STATUSLED_H
@@ -0,0 +1,194 @@
+#include <Arduino.h>
+
+#include <Oversample.h>
+
+#include "supply.h"
+#include "irq.h"
+#include "pins.h"
+
+#if defined(__arm__)
+#include <ADC.h>
+#endif
+
+
+static const char * const faultNames[] = SUPPLY_FAULT_NAMES;
+
+enum {
+  CH_SENSE,
+  CH_BANDGAP,
+  CH_TEMP,
+  CH_COUNT
+};
+
+static const uint8_t channels[CH_COUNT] = { SUPPLY_SENSE_IN, SUPPLY_BANDGAP_CHANNEL, SUPPLY_TEMP_CHANNEL };
+
+typedef Oversample<SUPPLY_ADC_BITS, SUPPLY_OVERSAMPLE_BITS> SupplyOversample;
+static_assert(SupplyOversample::RESULT_MAX == SUPPLY_RESULT_MAX, "SUPPLY_RESULT_MAX");
+static SupplyOversample burst;
+
+typedef struct {
+  int32_t last, min, max;
+  int64_t sum;
+  uint32_t count;
+} Stats;
+
+static Stats readings[SUPPLY_QUANTITY_COUNT];
+
+static uint8_t faults;
+
+
+#if defined(__arm__)
+
+static_assert(SUPPLY_TEMP_CHANNEL == (uint8_t)ADC_INTERNAL_SOURCE::TEMP_SENSOR, "SUPPLY_TEMP_CHANNEL");
+static_assert(SUPPLY_BANDGAP_CHANNEL == (uint8_t)ADC_INTERNAL_SOURCE::BANDGAP, "SUPPLY_BANDGAP_CHANNEL");
+
+static ADC adc;
+static volatile uint16_t raw[CH_COUNT];
+static volatile uint8_t channel;
+static volatile uint32_t scans;
+static uint32_t lastScans;
+static uint16_t calibratedOffset;
+
+void adc1_isr() {
+  IRQ_SCOPE(IRQ_SRC_ADC);
+  if (burst.add((uint16_t)adc.adc1->readSingle())) {
+    raw[channel] = (uint16_t)burst.result();
+    if (++channel == CH_COUNT) {
+      channel = 0;
+      scans++;
+    }
+    adc.adc1->startSingleRead(channels[channel]); // converts on the next PDB trigger
+  }
+#if SUPPLY_DITHER
+  ADC1_OFS = (uint16_t)(calibratedOffset + burst.dither());
+#endif
+}
+
+static bool started;
+
+void setupSupplyMonitor() {
+  PMC_REGSC |= PMC_REGSC_BGBE; // buffer the bandgap to the ADC
+}
+
+// The ADC library's setters wait for the calibration its constructor began, so nothing
+// touches ADC1 until the calibration is done
+static bool startScans() {
+  if (ADC1_SC3 & ADC_SC3_CAL) return false;
+  adc.setResolution(SUPPLY_ADC_BITS, ADC_1);
+  adc.setAveraging(1, ADC_1); // off: oversampling needs the noise
+  adc.setConversionSpeed(ADC_CONVERSION_SPEED::LOW_SPEED, ADC_1);
+  adc.setSamplingSpeed(ADC_SAMPLING_SPEED::VERY_LOW_SPEED, ADC_1); // the internal sources need a long sample
+  channel = 0;
+  burst.restart();
+  adc.adc1->startSingleRead(channels[0]); // writes the calibration results, OFS among them
+  calibratedOffset = ADC1_OFS;
+  adc.enableInterrupts(ADC_1);
+  adc.adc1->startPDB(SUPPLY_SCAN_HZ * CH_COUNT * SupplyOversample::SAMPLES);
+  started = true;
+  return true;
+}
+
+static bool nextScan(uint32_t, uint16_t *out) {
+  if (!started) {
+    startScans();
+    return false;
+  }
+  if (scans == lastScans) return false;
+  __disable_irq();
+  for (uint8_t i = 0; i < CH_COUNT; i++) out[i] = raw[i];
+  lastScans = scans;
+  __enable_irq();
+  return true;
+}
+
+#else
+
+static uint32_t lastScanMillis;
+
+void setupSupplyMonitor() {
+}
+
+static bool nextScan(uint32_t now, uint16_t *out) {
+  if (now - lastScanMillis < 1000 / SUPPLY_SCAN_HZ) return false;
+  lastScanMillis = now;
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    while (!burst.add(analogRead(channels[i]))) {}
+    out[i] = burst.result();
+  }
+  return true;
+}
+
+#endif // __arm__
+
+
+static void record(uint8_t quantity, int32_t value) {
+  Stats *r = &readings[quantity];
+  if (!r->count || value < r->min) r->min = value;
+  if (!r->count || value > r->max) r->max = value;
+  r->last = value;
+  r->sum += value;
+  r->count++;
+}
+
+// Raised when 'over', cleared only once 'clear' (past the hysteresis)
+static uint8_t check(uint8_t bits, uint8_t fault, bool over, bool clear) {
+  if (over) return bits | fault;
+  if (clear) return bits & ~fault;
+  return bits;
+}
+
+static void report(uint8_t was, uint8_t now) {
+  for (uint8_t bit = 0; bit < sizeof(faultNames) / sizeof(faultNames[0]); bit++) {
+    uint8_t mask = 1 << bit;
+    if ((was ^ now) & mask) {
+      Serial.print(now & mask ? "Supply fault: " : "Supply recovered: ");
+      Serial.print(faultNames[bit]);
+      Serial.print(" (12V ");
+      Serial.print(readings[SUPPLY_12V].last);
+      Serial.print(" mV, 3.3V ");
+      Serial.print(readings[SUPPLY_VDD].last);
+      Serial.println(" mV)");
+    }
+  }
+}
+
+void supplyMonitorCheck(uint32_t now) {
+  uint16_t scan[CH_COUNT];
+  if (!nextScan(now, scan)) return;
+  if (!scan[CH_BANDGAP]) return; // no reference, nothing to scale by
+
+  int32_t vdd = (int32_t)((uint32_t)SUPPLY_BANDGAP_MV * SUPPLY_RESULT_MAX / scan[CH_BANDGAP]);
+  int32_t supply = (int32_t)((uint64_t)scan[CH_SENSE] * vdd * (SUPPLY_DIVIDER_TOP + SUPPLY_DIVIDER_BOTTOM) /
+                             ((uint64_t)SUPPLY_RESULT_MAX * SUPPLY_DIVIDER_BOTTOM));
+  int32_t tempUv = (int32_t)((uint64_t)scan[CH_TEMP] * vdd * 1000 / SUPPLY_RESULT_MAX);
+  int32_t temp = 250 - (tempUv - SUPPLY_TEMP_25C_UV) * 10 / SUPPLY_TEMP_SLOPE_UV;
+  record(SUPPLY_12V, supply);
+  record(SUPPLY_VDD, vdd);
+  record(SUPPLY_TEMP, temp);
+
+  uint8_t f = faults;
+  f = check(f, SUPPLY_FAULT_LOW, supply < SUPPLY_LOW_MV, supply >= SUPPLY_LOW_MV + SUPPLY_HYSTERESIS_MV);
+  f = check(f, SUPPLY_FAULT_HIGH, supply > SUPPLY_HIGH_MV, supply <= SUPPLY_HIGH_MV - SUPPLY_HYSTERESIS_MV);
+  f = check(f, SUPPLY_FAULT_VDD, vdd < SUPPLY_VDD_MIN_MV || vdd > SUPPLY_VDD_MAX_MV,
+            vdd >= SUPPLY_VDD_MIN_MV + SUPPLY_HYSTERESIS_MV && vdd <= SUPPLY_VDD_MAX_MV - SUPPLY_HYSTERESIS_MV);
+  f = check(f, SUPPLY_FAULT_HOT, temp > SUPPLY_HOT_DC, temp <= SUPPLY_HOT_DC - SUPPLY_HYSTERESIS_DC);
+  if (f != faults) {
+    report(faults, f);
+    faults = f;
+  }
+}
+
+uint8_t supplyFaults() {
+  return faults;
+}
+
+bool supplyReading(uint8_t quantity, SupplyReading *out) {
+  if (quantity >= SUPPLY_QUANTITY_COUNT) return false;
+  const Stats *r = &readings[quantity];
+  out->last = r->last;
+  out->min = r->min;
+  out->max = r->max;
+  out->avg = r->count ? (int32_t)(r->sum / r->count) : 0;
+  out->count = r->count;
+  return true;
+}
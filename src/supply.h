@@ -0,0 +1,103 @@
+#ifndef SUPPLY_H
+#define SUPPLY_H
+
+#include <stdint.h>
+
+
+/* SUPPLY MONITOR
+ * ==========================================================================================
+ * Watches the 12 V rail (optos, ball gate relay coil), the Teensy's own 3.3 V and the die
+ * temperature, so that a sagging or failing supply shows up before it looks like a bad
+ * sensor. Three ADC1 channels are measured in turn, SUPPLY_SCAN_HZ full scans a second:
+ *
+ * Channel                  Measures                          Reported as
+ * ------------------------------------------------------------------------------------------
+ * SUPPLY_SENSE_IN (pins.h) +12 V through the                 SUPPLY_12V, mV
+ *                          SUPPLY_DIVIDER_* divider
+ * SUPPLY_BANDGAP_CHANNEL   the 1.0 V bandgap against VDD     SUPPLY_VDD, mV
+ * SUPPLY_TEMP_CHANNEL      the die temperature sensor        SUPPLY_TEMP, tenths of a degree C
+ *
+ * The bandgap turns the raw counts into volts: VDD = 1.0 V * full scale / bandgap counts,
+ * and the other two channels are scaled by that VDD rather than by a nominal 3.3 V.
+ *
+ * Each measurement is 4^SUPPLY_OVERSAMPLE_BITS single 12-bit conversions oversampled and
+ * decimated to 16 bits (lib/Oversample), with the hardware averaging off so that the noise
+ * and the dither through ADC1's offset register (SUPPLY_DITHER) are still there to be
+ * resolved. The PDB triggers every conversion and the ADC1 interrupt (IRQ_SRC_ADC, irq.h)
+ * adds it to the accumulator, sets the next dither offset and moves to the next channel
+ * once a burst is complete: a few thousand short ISRs a second and no waiting.
+ * supplyMonitorCheck() turns new scans into readings from the game thread: last, min, max
+ * and average since boot, and the faults below. The monitor owns ADC1: foreground
+ * analogRead()s use ADC0 and never wait on it. Nor does the boot: setupSupplyMonitor()
+ * runs after BOOT_READY and only buffers the bandgap, and supplyMonitorCheck() starts the
+ * scans once the ADC1 calibration has finished.
+ *
+ * Fault                Raised when                                   Cleared when
+ * ------------------------------------------------------------------------------------------
+ * SUPPLY_FAULT_LOW     12 V below SUPPLY_LOW_MV                      SUPPLY_HYSTERESIS_MV above
+ * SUPPLY_FAULT_HIGH    12 V above SUPPLY_HIGH_MV                     SUPPLY_HYSTERESIS_MV below
+ * SUPPLY_FAULT_VDD     3.3 V outside SUPPLY_VDD_MIN_MV..MAX_MV       SUPPLY_HYSTERESIS_MV inside
+ * SUPPLY_FAULT_HOT     die above SUPPLY_HOT_DC                       SUPPLY_HYSTERESIS_DC below
+ *
+ * Changes are logged, streamed as TM_EV_SUPPLY and shown by hsctl supply. In the simulator
+ * the channels read simSetAnalog() values once per scan period, and a bandgap of 0 (no
+ * values set) means no readings at all.
+ */
+
+#define SUPPLY_SCAN_HZ 4
+#define SUPPLY_ADC_BITS 12
+#define SUPPLY_ADC_MAX 4095          // one conversion
+#define SUPPLY_OVERSAMPLE_BITS 4     // 256 conversions per measurement, 16 bits
+#define SUPPLY_RESULT_MAX (SUPPLY_ADC_MAX << SUPPLY_OVERSAMPLE_BITS)
+#define SUPPLY_DITHER 1              // dither through ADC1_OFS
+
+#define SUPPLY_DIVIDER_TOP 47000     // ohms, +12 V to SUPPLY_SENSE_IN
+#define SUPPLY_DIVIDER_BOTTOM 10000  // ohms, SUPPLY_SENSE_IN to ground (2.1 V at 12 V)
+
+#define SUPPLY_TEMP_CHANNEL 38       // ADC_INTERNAL_SOURCE::TEMP_SENSOR
+#define SUPPLY_BANDGAP_CHANNEL 41    // ADC_INTERNAL_SOURCE::BANDGAP
+#define SUPPLY_BANDGAP_MV 1000
+#define SUPPLY_TEMP_25C_UV 719000    // sensor output at 25 C
+#define SUPPLY_TEMP_SLOPE_UV 1715    // per degree C, falling as it warms
+
+#define SUPPLY_LOW_MV 10800
+#define SUPPLY_HIGH_MV 13800
+#define SUPPLY_VDD_MIN_MV 3000
+#define SUPPLY_VDD_MAX_MV 3600
+#define SUPPLY_HOT_DC 700            // 70.0 C
+#define SUPPLY_HYSTERESIS_MV 200
+#define SUPPLY_HYSTERESIS_DC 50
+
+#define SUPPLY_FAULT_LOW 0x01
+#define SUPPLY_FAULT_HIGH 0x02
+#define SUPPLY_FAULT_VDD 0x04
+#define SUPPLY_FAULT_HOT 0x08
+
+#define SUPPLY_FAULT_NAMES { "12V low", "12V high", "3.3V out of range", "too hot" }
+
+enum SupplyQuantity {
+  SUPPLY_12V,
+  SUPPLY_VDD,
+  SUPPLY_TEMP,
+  SUPPLY_QUANTITY_COUNT
+};
+
+#define SUPPLY_QUANTITY_NAMES { "12V", "3.3V", "die temp" }
+
+typedef struct {
+  int32_t last;
+  int32_t min;
+  int32_t max;
+  int32_t avg;
+  uint32_t count;  // scans since boot
+} SupplyReading;
+
+void setupSupplyMonitor();
+// From the game thread; works through the scans that came in since the last call
+void supplyMonitorCheck(uint32_t now);
+
+uint8_t supplyFaults();
+bool supplyReading(uint8_t quantity, SupplyReading *out);
+
+
+#endif // SUPPLY_H
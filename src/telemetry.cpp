@@ -0,0 +1,539 @@
+#include <Arduino.h>
+
+#include <BlockPool.h>
+#include <CobsFrame.h>
+#include <Mailbox.h>
+
+#include "telemetry.h"
+#include "boot.h"
+#include "config.h"
+#include "crash.h"
+#include "cyclic.h"
+#include "game.h"
+#include "irq.h"
+#include "link.h"
+#include "memmap.h"
+#include "optomon.h"
+#include "pins.h"
+#include "probes.h"
+#include "record.h"
+#include "selftest.h"
+#include "shots.h"
+#include "supply.h"
+#include "threadmon.h"
+
+
+static const char *fwVersion = "";
+
+static uint8_t rxBuf[COBS_FRAME_MAX(TM_MAX_PAYLOAD)];
+static CobsFrameDecoder rx(rxBuf, sizeof(rxBuf));
+
+static uint8_t tx[TM_MAX_PAYLOAD];
+static uint8_t txLen;
+static uint8_t txFrame[COBS_FRAME_MAX(TM_MAX_PAYLOAD)];
+
+// event stream
+static uint8_t streamMask;
+static uint8_t eventSeq;
+static GameState lastState;
+static uint8_t lastCredits, lastRemainingSec;
+static uint8_t lastFaults[OPTO_COUNT];
+static uint8_t lastSupplyFaults;
+
+// test output pulse in progress
+static int8_t pulsePin = -1;
+static uint32_t pulseEndMillis;
+
+
+static void put8(uint8_t v) {
+  if (txLen < sizeof(tx)) tx[txLen++] = v;
+}
+
+static void put16(uint16_t v) {
+  put8(v);
+  put8(v >> 8);
+}
+
+static void put32(uint32_t v) {
+  put16(v);
+  put16(v >> 16);
+}
+
+static void put64(uint64_t v) {
+  put32(v);
+  put32(v >> 32);
+}
+
+static void putString(const char *s) {
+  while (*s && txLen < sizeof(tx)) put8(*s++);
+}
+
+static void begin(uint8_t type, uint8_t seq) {
+  txLen = 0;
+  put8(type);
+  put8(seq);
+}
+
+static void send() {
+  size_t n = cobs_frame_encode(tx, txLen, txFrame, sizeof(txFrame));
+  if (n == 0 || Serial.availableForWrite() < (int)n) return; // host will retry
+  Serial.write(txFrame, n);
+}
+
+static bool outputsIdle() {
+  return gameIdle() && pulsePin < 0 && !selfTestActive();
+}
+
+static uint8_t testOutput(uint8_t output, uint16_t arg) {
+  if (output >= TM_OUT_COUNT) return TM_STATUS_BAD_ARG;
+  if (!outputsIdle()) return TM_STATUS_BUSY;
+
+  if (output == TM_OUT_TICKETS) {
+    if (arg == 0 || arg > TELEMETRY_MAX_TICKETS) return TM_STATUS_BAD_ARG; // dispenseTickets() takes an int16_t
+    dispenseTickets(arg);
+    return TM_STATUS_OK;
+  }
+
+  if (arg == 0 || arg > TELEMETRY_MAX_PULSE_MS) return TM_STATUS_BAD_ARG;
+  switch (output) {
+    case TM_OUT_BALL_GATE: pulsePin = BALL_GATE_OUT; break;
+    case TM_OUT_TICKET_COUNTER: pulsePin = TICKET_COUNTER_OUT; break;
+    case TM_OUT_CREDIT_COUNTER: pulsePin = CREDIT_COUNTER_OUT; break;
+  }
+  digitalWriteFast(pulsePin, HIGH);
+  pulseEndMillis = millis() + arg;
+  return TM_STATUS_OK;
+}
+
+static void handleRequest(const uint8_t *req, int len) {
+  if (len < 2 || (req[0] & (TM_RESPONSE | TM_EVENT))) return;
+  uint8_t cmd = req[0];
+  const uint8_t *body = req + 2;
+  int bodyLen = len - 2;
+
+  begin(cmd | TM_RESPONSE, req[1]);
+  switch (cmd) {
+    case TM_PING:
+      put8(TM_STATUS_OK);
+      put8(TM_PROTO_VERSION);
+      put32(millis());
+      putString(fwVersion);
+      break;
+
+    case TM_GET_COUNTERS:
+      put8(TM_STATUS_OK);
+      put8((uint8_t)curGameState);
+      put8(curCredits);
+      put8(curScore);
+      put8(lastScore);
+      put8(remainingGameSec);
+      put16(ticketsQueued());
+      put32(gamesPlayed);
+      put32(coinsAccepted);
+      put32(ticketsDispensed);
+      break;
+
+    case TM_GET_PROBE: {
+      probe_stats_t st;
+      if (bodyLen < 1 || !probe_get(body[0], &st)) { // out of range, or probes compiled out
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      const char *name = probe_get_name(body[0]);
+      put8(TM_STATUS_OK);
+      put8(body[0]);
+      put32(st.count);
+      put32(st.min);
+      put32(st.max);
+      put64(st.sum);
+      put32(probe_ticks_per_us());
+      putString(name ? name : "");
+      break;
+    }
+
+    case TM_RESET_PROBES:
+      probe_reset();
+      put8(TM_STATUS_OK);
+      break;
+
+    case TM_GET_CONFIG:
+      put8(TM_STATUS_OK);
+      for (uint8_t i = 0; i < CFG_COUNT; i++) put8(configGet(i));
+      break;
+
+    case TM_SET_CONFIG:
+      if (bodyLen < 2 || !configSet(body[0], body[1])) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      applySetting(body[0]);
+      put8(TM_STATUS_OK);
+      break;
+
+    case TM_TEST_OUTPUT:
+      put8(bodyLen >= 3 ? testOutput(body[0], body[1] | (body[2] << 8)) : TM_STATUS_BAD_ARG);
+      break;
+
+    case TM_STREAM:
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      streamMask = body[0];
+      put8(TM_STATUS_OK);
+      break;
+
+    case TM_RECORD_READ: {
+      if (bodyLen < 4) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      uint32_t index = body[0] | (body[1] << 8) | ((uint32_t)body[2] << 16) | ((uint32_t)body[3] << 24);
+      uint32_t first = recordFirst();
+      if (index < first) index = first;
+      put8(TM_STATUS_OK);
+      put32(recordCount());
+      put32(first);
+      uint8_t nAt = txLen;
+      put8(0);
+      RecordEvent e;
+      for (uint8_t n = 0; n < TM_RECORD_EVENTS_MAX && recordGet(index + n, &e); n++) {
+        put32(e.micros);
+        put8(e.type);
+        put8(e.id);
+        put16(e.value);
+        tx[nAt]++;
+      }
+      break;
+    }
+
+    case TM_REPLAY:
+      put8(bodyLen >= 1 && replaySetMode(body[0]) ? TM_STATUS_OK : TM_STATUS_BUSY);
+      break;
+
+    case TM_INJECT:
+      if (bodyLen < 4) put8(TM_STATUS_BAD_ARG);
+      else if (!replayMode()) put8(TM_STATUS_BUSY);
+      else put8(recordInject(body[0], body[1], body[2] | (body[3] << 8)) ? TM_STATUS_OK : TM_STATUS_BAD_ARG);
+      break;
+
+    case TM_CRASH_REPORT:
+      put8(TM_STATUS_OK);
+      put8(crashPresent());
+      crashReport(Serial);
+      if (bodyLen >= 1 && body[0]) crashClear();
+      break;
+
+    case TM_GET_POOL: {
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      BlockPool *pool = NULL;
+      uint8_t pools = 0;
+      for (BlockPool *p = BlockPool::first(); p; p = p->next()) {
+        if (pools++ == body[0]) pool = p;
+      }
+      put8(TM_STATUS_OK);
+      put8(pools);
+      if (!pool) break;
+      put16(pool->blockSize());
+      put16(pool->capacity());
+      put16(pool->used());
+      put16(pool->peak());
+      put32(pool->failures());
+      putString(pool->name());
+      break;
+    }
+
+    case TM_GET_MAILBOX: {
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      Mailbox *box = NULL;
+      uint8_t boxes = 0;
+      for (Mailbox *m = Mailbox::first(); m; m = m->next()) {
+        if (boxes++ == body[0]) box = m;
+      }
+      put8(TM_STATUS_OK);
+      put8(boxes);
+      if (!box) break;
+      put16(box->capacity());
+      put16(box->pending());
+      put16(box->peak());
+      put32(box->posted());
+      put32(box->failures());
+      putString(box->name());
+      break;
+    }
+
+    case TM_GET_MEMORY: {
+      if (bodyLen < 2 || body[0] > TM_MEM_THREAD) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      MemoryUsage m;
+      uint8_t state = 0;
+      bool region = body[0] == TM_MEM_REGION;
+      put8(TM_STATUS_OK);
+      put8(region ? (memoryRegion(0, &m) ? MEM_REGION_COUNT : 0) : memoryThreadCount());
+      if (region ? !memoryRegion(body[1], &m) : !memoryThread(body[1], &m, &state)) break;
+      put8(state);
+      put32(m.start);
+      put32(m.size);
+      put32(m.used);
+      put32(m.peak);
+      break;
+    }
+
+    case TM_GET_BOOT:
+      put8(TM_STATUS_OK);
+      put8(BOOT_PHASE_COUNT);
+      put16(bootPhasesRun());
+      for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) put32(bootMicros(i));
+      break;
+
+    case TM_GET_LINK: {
+      LinkStatus l;
+      linkGetStatus(&l);
+      put8(TM_STATUS_OK);
+      put8(l.up);
+      put8(l.headToHead);
+      put8(l.peerState);
+      put8(l.peerScore);
+      put32(l.offset);
+      put32(l.rtt);
+      put32(l.frames);
+      put32(l.errors);
+      break;
+    }
+
+    case TM_GET_SHOTS: {
+      ShotSummary sum;
+      if (bodyLen < 1 || !shotsSummary(body[0], &sum)) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      uint8_t counts[SHOT_BUCKETS];
+      uint8_t n = shotsDistribution(counts);
+      put8(TM_STATUS_OK);
+      put16(sum.baskets);
+      put16(sum.misses);
+      put16(sum.swishes);
+      put16(sum.bestStreak);
+      put32(sum.minUs);
+      put32(sum.maxUs);
+      put64(sum.sumUs);
+      put16(shotStreak());
+      put32(SHOT_BUCKET_US);
+      put8(n);
+      for (uint8_t i = 0; i < SHOT_BUCKETS; i++) put8(counts[i]);
+      break;
+    }
+
+    case TM_SELF_TEST: {
+      if (bodyLen < 2 || body[0] > TM_SELFTEST_QUERY) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      if (body[0] == TM_SELFTEST_START && !selfTestStart()) {
+        put8(TM_STATUS_BUSY);
+        break;
+      }
+      if (body[0] == TM_SELFTEST_STOP) selfTestStop();
+      SelfTestLatency l;
+      put8(TM_STATUS_OK);
+      put8(selfTestActive());
+      put8(selfTestStep());
+      put8(SELFTEST_INPUT_COUNT);
+      if (!selfTestLatency(body[1], &l)) break;
+      put32(l.count);
+      put32(l.lastUs);
+      put32(l.minUs);
+      put32(l.maxUs);
+      put64(l.sumUs);
+      break;
+    }
+
+    case TM_GET_OPTO: {
+      OptoStatus o;
+      if (bodyLen < 1 || !optoStatus(body[0], &o)) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      put8(TM_STATUS_OK);
+      put8(o.blocked);
+      put8(o.faults);
+      put32(o.blockedMs);
+      put32(o.edges);
+      put16(o.rate);
+      put8(o.idleGames);
+      break;
+    }
+
+    case TM_GET_IRQ: {
+      IrqStatus q;
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      put8(TM_STATUS_OK);
+      put8(IRQ_SRC_COUNT);
+      if (!irqStatus(body[0], &q)) break;
+      put8(q.priority);
+      put16(q.budgetUs);
+      put32(q.count);
+      put32(q.maxRunNs);
+      put32(q.maxLatencyNs);
+      put32(q.overBudget);
+      put8(q.measured);
+      putString(irqName(body[0]));
+      break;
+    }
+
+    case TM_GET_TASK: {
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      CyclicStatus c;
+      CyclicTaskStatus t;
+      cyclicStatus(&c);
+      put8(TM_STATUS_OK);
+      put8(c.running);
+      put8(c.tasks);
+      put32(c.minorUs);
+      put8(c.minorFrames);
+      put32(c.frames);
+      put32(c.overruns);
+      put32(c.skipped);
+      put32(c.maxFrameUs);
+      if (!cyclicTask(body[0], &t)) break;
+      put8(t.offset);
+      put8(t.period);
+      put32(t.runs);
+      put32(t.lastUs);
+      put32(t.maxUs);
+      putString(cyclicTaskName(body[0]));
+      break;
+    }
+
+    case TM_GET_THREADS: {
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      ThreadStatus t;
+      uint8_t n = threadMonitor(body[0], &t);
+      put8(TM_STATUS_OK);
+      put8(n);
+      if (body[0] >= n) break;
+      put8(t.id);
+      put8(t.state);
+      put8(t.wait);
+      put8(t.priority);
+      put8(t.ticks);
+      put32(t.created);
+      put32(t.stackSize);
+      put32(t.stackPeak);
+      put64(t.cycles);
+      put32(threadCyclesPerUs());
+      putString(t.name);
+      break;
+    }
+
+    case TM_GET_SUPPLY: {
+      static const char * const names[SUPPLY_QUANTITY_COUNT] = SUPPLY_QUANTITY_NAMES;
+      if (bodyLen < 1) {
+        put8(TM_STATUS_BAD_ARG);
+        break;
+      }
+      SupplyReading r;
+      put8(TM_STATUS_OK);
+      put8(supplyFaults());
+      put8(SUPPLY_QUANTITY_COUNT);
+      if (!supplyReading(body[0], &r)) break;
+      put32(r.last);
+      put32(r.min);
+      put32(r.max);
+      put32(r.avg);
+      put32(r.count);
+      putString(names[body[0]]);
+      break;
+    }
+
+    default:
+      put8(TM_STATUS_UNKNOWN);
+      break;
+  }
+  send();
+}
+
+static void sendEvent(uint8_t event, uint16_t a, uint16_t b) {
+  if (!(streamMask & (1 << event))) return;
+  begin(TM_EVENT, eventSeq++);
+  put8(event);
+  put32(millis());
+  put16(a);
+  put16(b);
+  send();
+}
+
+static void pollEvents() {
+  GameState state = curGameState;
+  if (state != lastState) {
+    sendEvent(TM_EV_STATE, (uint8_t)state, 0);
+    if (lastState == GameState::GS_END && state == GameState::GS_ATTRACT) {
+      sendEvent(TM_EV_GAME_OVER, lastScore, lastScore * ticketsPerScore);
+    }
+    lastState = state;
+  }
+
+  if (curCredits != lastCredits) {
+    lastCredits = curCredits;
+    sendEvent(TM_EV_CREDIT, lastCredits, 0);
+  }
+
+  if (remainingGameSec != lastRemainingSec) {
+    lastRemainingSec = remainingGameSec;
+    if (state == GameState::GS_RUN || state == GameState::GS_LAST10) {
+      sendEvent(TM_EV_TICK, lastRemainingSec, 0);
+    }
+  }
+
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) {
+    if (optoFaults(i) != lastFaults[i]) {
+      lastFaults[i] = optoFaults(i);
+      sendEvent(TM_EV_FAULT, i, lastFaults[i]);
+    }
+  }
+
+  if (supplyFaults() != lastSupplyFaults) {
+    SupplyReading r;
+    lastSupplyFaults = supplyFaults();
+    supplyReading(SUPPLY_12V, &r);
+    sendEvent(TM_EV_SUPPLY, lastSupplyFaults, r.last > 0 ? r.last : 0);
+  }
+}
+
+void setupTelemetry(const char *version) {
+  fwVersion = version;
+  lastState = curGameState;
+  lastCredits = curCredits;
+  lastRemainingSec = remainingGameSec;
+}
+
+void telemetryPoll() {
+  for (int budget = TELEMETRY_RX_BUDGET; budget > 0 && Serial.available() > 0; budget--) {
+    int len = rx.push(Serial.read());
+    if (len > 0) handleRequest(rx.data(), len);
+  }
+
+  if (pulsePin >= 0 && (int32_t)(millis() - pulseEndMillis) >= 0) {
+    digitalWriteFast(pulsePin, LOW);
+    pulsePin = -1;
+  }
+
+  pollEvents();
+}
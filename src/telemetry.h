@@ -0,0 +1,31 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#include "telemetry_proto.h"
+
+
+/* TELEMETRY
+ * ==========================================================================================
+ * Device side of the binary protocol in telemetry_proto.h.
+ *
+ * telemetryPoll() feeds whatever Serial has buffered through the frame decoder, answers
+ * complete requests, sends enabled events and ends test-output pulses, then returns. It
+ * never waits for input, and frames are dropped rather than waited on when the USB
+ * transmit buffer is full, so a slow or absent host cannot stall the caller. It runs in
+ * its own thread on the device and from the simulator loop on the host.
+ *
+ * Events are generated by comparing the game state on each poll, so their timestamps are
+ * the poll time, not the moment the state changed.
+ */
+
+#define TELEMETRY_RX_BUDGET 64        // bytes decoded per poll, at most
+#define TELEMETRY_MAX_PULSE_MS 10000  // longest test-output pulse
+#define TELEMETRY_MAX_TICKETS 100     // most tickets one test-output request dispenses
+
+void setupTelemetry(const char *version);
+void telemetryPoll();
+
+
+#endif // TELEMETRY_H
@@ -0,0 +1,157 @@
+#ifndef TELEMETRY_PROTO_H
+#define TELEMETRY_PROTO_H
+
+#include <stdint.h>
+
+
+/* TELEMETRY PROTOCOL
+ * ====================================================================================================
+ * Binary request/response protocol on the USB serial port, shared by the firmware (telemetry.cpp)
+ * and the host client (tools/hsctl.cpp). Every message is one CobsFrame frame (lib/CobsFrame), so
+ * frames can share the port with the existing Serial.print text: a receiver drops anything that
+ * fails the CRC.
+ *
+ * Payload    [type u8] [seq u8] [body...]            multi-byte fields are little-endian
+ * Request    type = TM_* command, seq chosen by the host
+ * Response   type = command | TM_RESPONSE, same seq, body starts with a TM_STATUS_* byte
+ * Event      type = TM_EVENT, seq counts events (a gap means events were dropped),
+ *            body = [event u8] [millis u32] [a u16] [b u16]
+ *
+ * Command            Request body              Response body (after status)
+ * ----------------------------------------------------------------------------------------------------
+ * TM_PING            -                         proto u8, millis u32, version string
+ * TM_GET_COUNTERS    -                         state u8, credits u8, score u8, lastScore u8,
+ *                                              remainingSec u8, ticketsPending u16,
+ *                                              games u32, coins u32, tickets u32
+ * TM_GET_PROBE       id u8                     id u8, count u32, min u32, max u32, sum u64,
+ *                                              ticksPerUs u32, name string (empty if unused)
+ * TM_RESET_PROBES    -                         -
+ * TM_GET_CONFIG      -                         CFG_COUNT values, u8 each, in ConfigField order
+ * TM_SET_CONFIG      field u8, value u8        - (stored to EEPROM)
+ * TM_TEST_OUTPUT     output u8, arg u16        - (attract mode only; arg = pulse ms, or tickets,
+ *                                              up to TELEMETRY_MAX_PULSE_MS / _MAX_TICKETS)
+ * TM_STREAM          event mask u8             - (bit n enables event n)
+ * TM_RECORD_READ     index u32                 count u32, first u32, n u8, then n events of
+ *                                              micros u32, type u8, id u8, value u16 (record.h)
+ * TM_REPLAY          enable u8                 - (enable only while idle)
+ * TM_INJECT          type u8, id u8, value u16 - (replay mode only; input events)
+ * TM_CRASH_REPORT    clear u8                  present u8; the dump itself (crash.h) is printed
+ *                                              as text ahead of the response, then cleared if
+ *                                              asked to
+ * TM_GET_POOL        index u8                  pools u8 (number in use), then if index < pools:
+ *                                              blockSize u16, capacity u16, used u16, peak u16,
+ *                                              failures u32, name string (lib/BlockPool)
+ * TM_GET_MAILBOX     index u8                  mailboxes u8 (number in use), then if index <
+ *                                              mailboxes: capacity u16, pending u16, peak u16,
+ *                                              posted u32, failures u32, name string
+ *                                              (lib/Mailbox)
+ * TM_GET_MEMORY      kind u8, index u8         count u8, then if index < count: state u8,
+ *                                              start u32, size u32, used u32, peak u32 (bytes);
+ *                                              kind TM_MEM_REGION: MemoryRegion, state 0;
+ *                                              kind TM_MEM_THREAD: thread id and state (memmap.h)
+ * TM_GET_BOOT        -                         n u8, ran u16 (bit per phase), then n phase end
+ *                                              times u32 (us since reset), in BootPhase order
+ *                                              (boot.h)
+ * TM_GET_LINK        -                         up u8, headToHead u8, peerState u8, peerScore u8,
+ *                                              offset i32 (us), rtt u32 (us), frames u32,
+ *                                              errors u32 (link.h)
+ * TM_GET_SHOTS       kind u8                   baskets u16, misses u16, swishes u16,
+ *                                              bestStreak u16, minUs u32, maxUs u32, sumUs u64
+ *                                              of ShotSummaryKind 'kind'; then streak u16,
+ *                                              bucketUs u32, n u8 (transits in the rolling
+ *                                              distribution), SHOT_BUCKETS counts u8 (shots.h)
+ * TM_GET_OPTO        opto u8                   blocked u8, faults u8, blockedMs u32, edges u32,
+ *                                              rate u16, idleGames u8 (optomon.h)
+ * TM_SELF_TEST       action u8, input u8       active u8, step u8, inputs u8, then if input <
+ *                                              inputs: count u32, lastUs u32, minUs u32,
+ *                                              maxUs u32, sumUs u64 (selftest.h); action
+ *                                              TM_SELFTEST_STOP/START/QUERY; start is BUSY
+ *                                              unless the game is idle
+ * TM_GET_IRQ         source u8                 sources u8, then if source < sources: priority u8,
+ *                                              budgetUs u16, count u32, maxRunNs u32,
+ *                                              maxLatencyNs u32, overBudget u32, measured u8,
+ *                                              name string (irq.h)
+ * TM_GET_TASK        index u8                  running u8, tasks u8, minorUs u32, minorFrames u8,
+ *                                              frames u32, overruns u32, skipped u32,
+ *                                              maxFrameUs u32, then if index < tasks: offset u8,
+ *                                              period u8, runs u32, lastUs u32, maxUs u32, name
+ *                                              string (cyclic.h)
+ * TM_GET_THREADS     index u8                  threads u8 (number in use), then if index <
+ *                                              threads: id u8, state u8, wait u8, priority u8,
+ *                                              ticks u8, created u32 (ms), stackSize u32,
+ *                                              stackPeak u32, cycles u64, cyclesPerUs u32,
+ *                                              name string (threadmon.h)
+ * TM_GET_SUPPLY      quantity u8               faults u8, quantities u8, then if quantity <
+ *                                              quantities: last i32, min i32, max i32,
+ *                                              avg i32, count u32, name string (supply.h;
+ *                                              mV, or tenths of a degree C)
+ */
+
+#define TM_PROTO_VERSION 1
+#define TM_MAX_PAYLOAD 64
+
+#define TM_RESPONSE 0x80
+#define TM_EVENT 0x40
+
+enum TelemetryCommand {
+  TM_PING = 0x01,
+  TM_GET_COUNTERS = 0x02,
+  TM_GET_PROBE = 0x03,
+  TM_RESET_PROBES = 0x04,
+  TM_GET_CONFIG = 0x05,
+  TM_SET_CONFIG = 0x06,
+  TM_TEST_OUTPUT = 0x07,
+  TM_STREAM = 0x08,
+  TM_RECORD_READ = 0x09,
+  TM_REPLAY = 0x0A,
+  TM_INJECT = 0x0B,
+  TM_CRASH_REPORT = 0x0C,
+  TM_GET_POOL = 0x0D,
+  TM_GET_MEMORY = 0x0E,
+  TM_GET_BOOT = 0x0F,
+  TM_GET_LINK = 0x10,
+  TM_GET_SHOTS = 0x11,
+  TM_GET_OPTO = 0x12,
+  TM_SELF_TEST = 0x13,
+  TM_GET_IRQ = 0x14,
+  TM_GET_MAILBOX = 0x15,
+  TM_GET_TASK = 0x16,
+  TM_GET_THREADS = 0x17,
+  TM_GET_SUPPLY = 0x18,
+};
+
+#define TM_RECORD_EVENTS_MAX 6 // events per TM_RECORD_READ response
+
+#define TM_SELFTEST_STOP 0
+#define TM_SELFTEST_START 1
+#define TM_SELFTEST_QUERY 2
+
+#define TM_MEM_REGION 0
+#define TM_MEM_THREAD 1
+
+enum TelemetryStatus {
+  TM_STATUS_OK = 0,
+  TM_STATUS_UNKNOWN = 1,  // unknown command
+  TM_STATUS_BAD_ARG = 2,  // malformed body or argument out of range
+  TM_STATUS_BUSY = 3,     // not allowed while a game is running (or outside replay mode)
+};
+
+enum TelemetryEvent {
+  TM_EV_STATE = 0,     // a = new GameState
+  TM_EV_CREDIT = 1,    // a = credits
+  TM_EV_TICK = 2,      // a = seconds left in the game
+  TM_EV_GAME_OVER = 3, // a = score, b = tickets earned
+  TM_EV_FAULT = 4,     // a = opto, b = its OPTO_FAULT_* bits (optomon.h), on every change
+  TM_EV_SUPPLY = 5,    // a = SUPPLY_FAULT_* bits (supply.h), b = 12 V in mV, on every change
+};
+
+enum TelemetryOutput {
+  TM_OUT_BALL_GATE = 0,
+  TM_OUT_TICKETS = 1,        // arg = tickets to dispense
+  TM_OUT_TICKET_COUNTER = 2,
+  TM_OUT_CREDIT_COUNTER = 3,
+  TM_OUT_COUNT
+};
+
+
+#endif // TELEMETRY_PROTO_H
@@ -0,0 +1,56 @@
+#include <Arduino.h>
+
+#include "threadmon.h"
+#include "memmap.h"
+
+#if defined(__arm__)
+#include <TeensyThreads.h>
+#endif
+
+
+#if defined(__arm__)
+
+static_assert(THREAD_MONITOR_MAX == Threads::MAX_THREADS, "THREAD_MONITOR_MAX");
+
+static ThreadSnapshot snap[THREAD_MONITOR_MAX]; // off the telemetry thread's stack
+
+uint8_t threadMonitor(uint8_t index, ThreadStatus *out) {
+  int n = threads.snapshot(snap, THREAD_MONITOR_MAX);
+  if (index >= n) return n;
+
+  const ThreadSnapshot *s = &snap[index];
+  out->id = s->id;
+  out->state = s->state;
+  out->wait = s->wait;
+  out->priority = s->priority;
+  out->ticks = s->ticks;
+  out->created = s->created;
+  out->stackSize = s->stack_size;
+  out->stackPeak = s->stack_peak < 0 ? 0 : s->stack_peak;
+  out->cycles = s->cycles;
+  out->name = s->name ? s->name : "";
+  if (s->id == 0) { // the main stack: its figures come from the memory map
+    MemoryUsage m;
+    if (memoryRegion(MEM_STACK, &m)) {
+      out->stackSize = m.size;
+      out->stackPeak = m.peak;
+    }
+  }
+  return n;
+}
+
+uint32_t threadCyclesPerUs() {
+  return F_CPU / 1000000;
+}
+
+#else
+
+uint8_t threadMonitor(uint8_t, ThreadStatus *) {
+  return 0;
+}
+
+uint32_t threadCyclesPerUs() {
+  return 1;
+}
+
+#endif // __arm__
@@ -0,0 +1,53 @@
+#ifndef THREADMON_H
+#define THREADMON_H
+
+#include <stdint.h>
+
+
+/* THREAD MONITOR
+ * ==========================================================================================
+ * What each TeensyThreads thread is, what it is doing and how much CPU it takes: the
+ * cabinet's `top`, read over telemetry with hsctl threads.
+ *
+ * Field        From
+ * ------------------------------------------------------------------------------------------
+ * name         threads.setName() in main.cpp; thread 0 is "main" (loop() and the ISRs'
+ *              stack)
+ * state        Threads::RUNNING, SUSPENDED, ... (shown like hsctl memory)
+ * wait         Threads::WAIT_*: delay, join, mutex or message (a mailbox receive)
+ * priority     pending priority slices, slice ticks per turn
+ * created      millis() when the thread was added
+ * stack        size and peak, as in memmap.h
+ * cycles       CPU cycles since creation, counted at each context switch, so the ISRs
+ *              are charged to whichever thread they interrupted
+ *
+ * threadMonitor() copies the table in one short interrupts-off pass (threads.snapshot())
+ * and scans the stacks after, so asking costs the scheduler almost nothing. The copy goes
+ * to a static buffer rather than the caller's stack, which on the telemetry thread (its
+ * only caller) is a 1 KB pooled one; so calls must not overlap. CPU use is the
+ * difference in cycles between two reads over the time between them.
+ *
+ * On the host there are no threads and threadMonitor() reports none.
+ */
+
+#define THREAD_MONITOR_MAX 8 // Threads::MAX_THREADS
+
+typedef struct {
+  uint8_t id;
+  uint8_t state;
+  uint8_t wait;
+  uint8_t priority;
+  uint8_t ticks;
+  uint32_t created;
+  uint32_t stackSize;
+  uint32_t stackPeak;
+  uint64_t cycles;
+  const char *name;
+} ThreadStatus;
+
+// The number of threads in use; 'out' gets the index-th of them, if there is one
+uint8_t threadMonitor(uint8_t index, ThreadStatus *out);
+uint32_t threadCyclesPerUs();
+
+
+#endif // THREADMON_H
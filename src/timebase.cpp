@@ -0,0 +1,59 @@
+#include <Arduino.h>
+
+#include "timebase.h"
+
+#if !defined(__arm__)
+#include <sim.h>
+#endif
+
+
+#if defined(__arm__)
+
+#include <BlockPool.h> // block_pool_lock()
+
+#define SYSTICK_PER_US (F_CPU / 1000000)
+
+static uint32_t lastMillis; // the 32-bit SysTick count at the last reading
+static uint32_t millisWraps;
+
+// The SysTick count extended to 64 bits, and the SysTick ticks into the current millisecond.
+// Restores the caller's interrupt mask rather than enabling interrupts, since callers such as
+// recordInject() read the time with them masked.
+static uint64_t snapshot(uint32_t *ticks) {
+  uint32_t primask = block_pool_lock();
+  uint32_t current = SYST_CVR;
+  uint32_t count = systick_millis_count;
+  uint32_t istatus = SCB_ICSR;
+  // the SysTick wrapped but its interrupt has not run yet
+  if ((istatus & SCB_ICSR_PENDSTSET) && current > 50) count++;
+  if (count < lastMillis) millisWraps++;
+  lastMillis = count;
+  uint32_t wraps = millisWraps;
+  block_pool_unlock(primask);
+
+  *ticks = ((F_CPU / 1000) - 1) - current;
+  return ((uint64_t)wraps << 32) | count;
+}
+
+uint64_t timeMicros() {
+  uint32_t ticks;
+  uint64_t ms = snapshot(&ticks);
+  return ms * 1000 + ticks / SYSTICK_PER_US;
+}
+
+uint64_t timeMillis() {
+  uint32_t ticks;
+  return snapshot(&ticks);
+}
+
+#else
+
+uint64_t timeMicros() {
+  return simMicros();
+}
+
+uint64_t timeMillis() {
+  return simMicros() / 1000;
+}
+
+#endif // __arm__
@@ -0,0 +1,31 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+
+/* TIME BASE
+ * ==========================================================================================
+ * One monotonic clock for the whole firmware, in microseconds since reset, 64 bits wide so
+ * it never wraps (584,000 years) and differences between any two readings are plain
+ * subtraction.
+ *
+ * It reads the core's SysTick millisecond count and the SysTick current value together with
+ * interrupts masked for a few instructions, the same way the core's micros() does, and
+ * extends the 32-bit millisecond count with a wrap counter. It is safe from ISRs and
+ * threads. The only requirement is that something reads it at least once every 49 days,
+ * which the game thread does all the time.
+ *
+ * micros() and millis() count on the same SysTick, so their low 32 bits agree with
+ * timeMicros() and timeMillis(), and the scheduler's (TeensyThreads) delays are on the same
+ * clock. Input timestamps (coin, optos, self-test captures), the event recorder, boot marks
+ * and the buttons (menu.cpp) read it directly.
+ *
+ * In the host simulator it is the simulator's virtual clock.
+ */
+
+uint64_t timeMicros();
+uint64_t timeMillis();
+
+
+#endif // TIMEBASE_H
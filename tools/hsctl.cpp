@@ -0,0 +1,836 @@
+/*
+ * hsctl.cpp - host client for the cabinet's binary telemetry protocol
+ * (src/telemetry_proto.h).
+ *
+ * usage: hsctl [-d device] [-t timeout-ms] command [args]
+ *
+ *   ping                       protocol version, uptime and firmware version
+ *   counters                   game state and lifetime counters
+ *   probes                     timing probe statistics
+ *   reset-probes               clear the timing probes
+ *   pools                      block pool and mailbox usage (lib/BlockPool, lib/Mailbox)
+ *   memory                     RAM use by region and thread stack (src/memmap.h)
+ *   boot                       how long each startup phase took (src/boot.h)
+ *   link                       state of the link to the other cabinet (src/link.h)
+ *   optos                      opto beam state and faults (src/optomon.h)
+ *   supply                     12 V, 3.3 V and die temperature: last, min, max,
+ *                              average and faults (src/supply.h)
+ *   tasks                      the cyclic executive's schedule, frame overruns and
+ *                              per-task execution times (src/cyclic.h)
+ *   threads                    each thread's state, wait, stack and CPU use over a
+ *                              second, like top (src/threadmon.h)
+ *   irqs                       interrupt priorities, handler times and entry latency
+ *                              against each source's budget (src/irq.h)
+ *   selftest [start|stop]      run the output/input self-test and show input latencies
+ *                              (src/selftest.h)
+ *   shots                      shot analytics: game, last game and lifetime summaries
+ *                              and the distribution of recent transits (src/shots.h)
+ *   config                     show the programmable settings
+ *   set <setting> <value>      change a setting (stored in EEPROM)
+ *   test <output> <arg>        pulse an output for <arg> ms, or dispense <arg> tickets
+ *   monitor [event...]         print events and log text until interrupted
+ *   crash [clear]              print the crash dump kept from the last fault (and
+ *                              clear it); feed it to tools/symbolize.py
+ *   record [from]              dump the input recording (src/record.h) as text
+ *   replay <file>              play a recording's inputs into the cabinet in replay
+ *                              mode, at their recorded pace; then check the result
+ *                              with hsctl record <from> and hotshot-replay -c
+ *
+ * The device defaults to $HOTSHOT_PORT, then /dev/ttyACM0. hotshot-sim -P
+ * serves the same protocol on a pseudo-terminal.
+ */
+
+#include <CobsFrame.h>
+#include <Probe.h>
+
+#include "boot.h"
+#include "config.h"
+#include "game.h"
+#include "memmap.h"
+#include "optomon.h"
+#include "record.h"
+#include "selftest.h"
+#include "shots.h"
+#include "supply.h"
+#include "telemetry_proto.h"
+#include "threadmon.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RETRIES 3
+
+static const char *settingNames[CFG_COUNT] = {
+  "high-score", "tickets-per-score", "plays-per-credit", "play-time", "attract-time"
+};
+static const char *outputNames[TM_OUT_COUNT] = {
+  "ball-gate", "tickets", "ticket-counter", "credit-counter"
+};
+static const char *eventNames[] = { "state", "credit", "tick", "game-over", "fault", "supply" };
+static const char *stateNames[] = { "start", "run", "last10", "end", "attract" };
+static const char *recordTypeNames[REC_TYPE_COUNT] = REC_TYPE_NAMES;
+
+static int fd = -1;
+static unsigned timeoutMs = 500;
+static uint8_t seq;
+
+static uint8_t rxBuf[COBS_FRAME_MAX(TM_MAX_PAYLOAD)];
+static CobsFrameDecoder rx(rxBuf, sizeof(rxBuf));
+static char text[256];
+static size_t textLen;
+static bool showText;
+
+static volatile sig_atomic_t stop;
+
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+static uint64_t get64(const uint8_t *p) { return get32(p) | ((uint64_t)get32(p + 4) << 32); }
+
+static const char *stateName(uint8_t s) {
+  return s < sizeof(stateNames) / sizeof(stateNames[0]) ? stateNames[s] : "?";
+}
+
+static int lookup(const char *name, const char **names, int count) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(name, names[i]) == 0) return i;
+  }
+  return -1;
+}
+
+static int openPort(const char *path) {
+  fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200); // ignored by USB serial
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  tcflush(fd, TCIFLUSH);
+  return 0;
+}
+
+static void flushText() {
+  if (showText && textLen) {
+    bool printable = true;
+    for (size_t i = 0; i < textLen; i++) {
+      if (!isprint((unsigned char)text[i]) && !isspace((unsigned char)text[i])) printable = false;
+    }
+    if (printable) fwrite(text, 1, textLen, stdout);
+  }
+  textLen = 0;
+}
+
+/*
+ * Read for up to 'ms' and return the length of the next valid frame (at
+ * rx.data()), 0 on timeout or -1 on error. Text between frames is printed
+ * when showText is set.
+ */
+static int readFrame(unsigned ms) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (;;) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+    if (elapsed >= (long)ms || stop) return 0;
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int r = poll(&pfd, 1, ms - elapsed);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      return -1;
+    }
+    if (r == 0) return 0;
+
+    uint8_t b;
+    ssize_t n = read(fd, &b, 1);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      fprintf(stderr, "hsctl: device closed\n");
+      return -1;
+    }
+
+    int len = rx.push(b);
+    if (b == 0) {
+      if (len > 0) textLen = 0;
+      else flushText();
+      if (len > 0) return len;
+    } else {
+      if (textLen < sizeof(text)) text[textLen++] = b;
+      if (b == '\n') flushText();
+    }
+  }
+}
+
+/*
+ * Send a request and wait for its response. Returns the response body
+ * length after the status byte (body at *out), or -1.
+ */
+static int request(uint8_t cmd, const uint8_t *body, size_t bodyLen, const uint8_t **out) {
+  uint8_t payload[TM_MAX_PAYLOAD];
+  uint8_t frame[COBS_FRAME_MAX(TM_MAX_PAYLOAD)];
+
+  for (int attempt = 0; attempt < RETRIES; attempt++) {
+    uint8_t s = ++seq;
+    payload[0] = cmd;
+    payload[1] = s;
+    if (bodyLen) memcpy(payload + 2, body, bodyLen);
+    size_t n = cobs_frame_encode(payload, bodyLen + 2, frame, sizeof(frame));
+    if (write(fd, frame, n) != (ssize_t)n) {
+      perror("write");
+      return -1;
+    }
+
+    int len;
+    while ((len = readFrame(timeoutMs)) > 0) {
+      const uint8_t *p = rx.data();
+      if (len < 3 || p[0] != (cmd | TM_RESPONSE) || p[1] != s) continue; // event or stale response
+      if (p[2] != TM_STATUS_OK) {
+        static const char *errors[] = { "ok", "unknown command", "bad argument", "busy (game in progress)" };
+        fprintf(stderr, "hsctl: %s\n", p[2] < 4 ? errors[p[2]] : "error");
+        return -1;
+      }
+      *out = p + 3;
+      return len - 3;
+    }
+    if (len < 0) return -1;
+  }
+  fprintf(stderr, "hsctl: no response\n");
+  return -1;
+}
+
+static int cmdPing() {
+  const uint8_t *p;
+  int len = request(TM_PING, 0, 0, &p);
+  if (len < 5) return 1;
+  printf("protocol %u, up %.3f s, firmware %.*s\n", p[0], get32(p + 1) / 1e3, len - 5, p + 5);
+  return 0;
+}
+
+static int cmdCounters() {
+  const uint8_t *p;
+  int len = request(TM_GET_COUNTERS, 0, 0, &p);
+  if (len < 19) return 1;
+  printf("state           %s\n", stateName(p[0]));
+  printf("credits         %u\n", p[1]);
+  printf("score           %u\n", p[2]);
+  printf("last score      %u\n", p[3]);
+  printf("seconds left    %u\n", p[4]);
+  printf("tickets queued  %u\n", get16(p + 5));
+  printf("games played    %u\n", get32(p + 7));
+  printf("coins accepted  %u\n", get32(p + 11));
+  printf("tickets paid    %u\n", get32(p + 15));
+  return 0;
+}
+
+static int cmdProbes() {
+  printf("%-16s %10s %10s %10s %10s  (us)\n", "probe", "count", "min", "avg", "max");
+  for (uint8_t id = 0; id < PROBE_MAX; id++) {
+    const uint8_t *p;
+    int len = request(TM_GET_PROBE, &id, 1, &p);
+    if (len < 25) return 1;
+    uint32_t count = get32(p + 1);
+    if (!count) continue;
+    double tpu = get32(p + 21);
+    printf("%-16.*s %10u %10.2f %10.2f %10.2f\n", len - 25, p + 25, count,
+           get32(p + 5) / tpu, get64(p + 13) / tpu / count, get32(p + 9) / tpu);
+  }
+  return 0;
+}
+
+static int cmdPools() {
+  printf("%-12s %6s %8s %6s %6s %8s\n", "pool", "block", "capacity", "used", "peak", "failures");
+  uint8_t pools = 1;
+  for (uint8_t i = 0; i < pools; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_POOL, &i, 1, &p);
+    if (len < 1) return 1;
+    pools = p[0];
+    if (i >= pools) break;
+    if (len < 13) return 1;
+    printf("%-12.*s %6u %8u %6u %6u %8u\n", len - 13, p + 13, get16(p + 1), get16(p + 3), get16(p + 5),
+           get16(p + 7), get32(p + 9));
+  }
+
+  printf("\n%-12s %8s %8s %6s %10s %8s\n", "mailbox", "capacity", "pending", "peak", "posted", "failures");
+  uint8_t boxes = 1;
+  for (uint8_t i = 0; i < boxes; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_MAILBOX, &i, 1, &p);
+    if (len < 1) return 1;
+    boxes = p[0];
+    if (i >= boxes) break;
+    if (len < 15) return 1;
+    printf("%-12.*s %8u %8u %6u %10u %8u\n", len - 15, p + 15, get16(p + 1), get16(p + 3), get16(p + 5),
+           get32(p + 7), get32(p + 11));
+  }
+  return 0;
+}
+
+static int cmdMemory() {
+  static const char *regionNames[MEM_REGION_COUNT] = MEM_REGION_NAMES;
+  static const char *threadStates[] = { "empty", "running", "ended", "ending", "suspended" };
+
+  for (uint8_t kind = TM_MEM_REGION; kind <= TM_MEM_THREAD; kind++) {
+    printf("%-12s %10s %8s %8s %8s %8s\n", kind == TM_MEM_REGION ? "region" : "thread", "start", "size",
+           "used", "peak", "free");
+    uint8_t count = 1;
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t body[2] = { kind, i };
+      const uint8_t *p;
+      int len = request(TM_GET_MEMORY, body, 2, &p);
+      if (len < 1) return 1;
+      count = p[0];
+      if (i >= count) break;
+      if (len < 18) return 1;
+      uint32_t size = get32(p + 6), peak = get32(p + 14);
+      char name[24];
+      if (kind == TM_MEM_REGION) snprintf(name, sizeof(name), "%s", i < MEM_REGION_COUNT ? regionNames[i] : "?");
+      else if (p[1] == 0) continue; // unused slot
+      else snprintf(name, sizeof(name), "%u %s", i, p[1] < 5 ? threadStates[p[1]] : "?");
+      printf("%-12s 0x%08x %8u %8u %8u %8d\n", name, get32(p + 2), size, get32(p + 10), peak, (int)(size - peak));
+    }
+    if (kind == TM_MEM_REGION && count == 0) printf("(not available)\n");
+  }
+  return 0;
+}
+
+static int cmdBoot() {
+  static const char *phaseNames[BOOT_PHASE_COUNT] = BOOT_PHASE_NAMES;
+  const uint8_t *p;
+  int len = request(TM_GET_BOOT, 0, 0, &p);
+  if (len < 3 || len < 3 + p[0] * 4) return 1;
+
+  printf("%-10s %10s %10s\n", "phase", "done (us)", "took (us)");
+  uint32_t last = 0;
+  for (uint8_t i = 0; i < p[0]; i++) {
+    if (!(get16(p + 1) & (1 << i))) continue; // did not run
+    uint32_t us = get32(p + 3 + i * 4);
+    printf("%-10s %10u %10u\n", i < BOOT_PHASE_COUNT ? phaseNames[i] : "?", us, us - last);
+    last = us;
+  }
+  return 0;
+}
+
+static int cmdLink() {
+  const uint8_t *p;
+  int len = request(TM_GET_LINK, 0, 0, &p);
+  if (len < 20) return 1;
+  printf("link            %s\n", p[0] ? "up" : "down");
+  printf("head-to-head    %s\n", p[1] ? "yes" : "no");
+  printf("peer state      %s\n", stateName(p[2]));
+  printf("peer score      %u\n", p[3]);
+  printf("clock offset    %d us\n", (int32_t)get32(p + 4));
+  printf("round trip      %u us\n", get32(p + 8));
+  printf("frames          %u\n", get32(p + 12));
+  printf("errors          %u\n", get32(p + 16));
+  return 0;
+}
+
+static const char *optoNames[OPTO_COUNT] = { "upper", "lower" };
+
+static const char *faultText(uint8_t faults, const char * const *names, unsigned count) {
+  static char text[64];
+  text[0] = 0;
+  for (unsigned bit = 0; bit < count; bit++) {
+    if (!(faults & (1 << bit))) continue;
+    if (text[0]) strcat(text, ",");
+    strcat(text, names[bit]);
+  }
+  return text[0] ? text : "none";
+}
+
+static const char *faultText(uint8_t faults) {
+  static const char *names[] = OPTO_FAULT_NAMES;
+  return faultText(faults, names, sizeof(names) / sizeof(names[0]));
+}
+
+static const char *supplyFaultText(uint8_t faults) {
+  static const char *names[] = SUPPLY_FAULT_NAMES;
+  return faultText(faults, names, sizeof(names) / sizeof(names[0]));
+}
+
+static int cmdSupply() {
+  uint8_t quantities = 1;
+  for (uint8_t i = 0; i < quantities; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_SUPPLY, &i, 1, &p);
+    if (len < 2) return 1;
+    if (i == 0) {
+      printf("faults          %s\n", supplyFaultText(p[0]));
+      printf("%-10s %10s %10s %10s %10s %10s\n", "", "last", "min", "max", "average", "scans");
+      quantities = p[1];
+    }
+    if (len < 22) return 1;
+    if (!get32(p + 18)) {
+      printf("(no readings)\n");
+      break;
+    }
+    // mV, except the temperature in tenths of a degree
+    double scale = i == SUPPLY_TEMP ? 10.0 : 1000.0;
+    printf("%-10.*s %10.2f %10.2f %10.2f %10.2f %10u  %s\n", len - 22, p + 22, (int32_t)get32(p + 2) / scale,
+           (int32_t)get32(p + 6) / scale, (int32_t)get32(p + 10) / scale, (int32_t)get32(p + 14) / scale,
+           get32(p + 18), i == SUPPLY_TEMP ? "C" : "V");
+  }
+  return 0;
+}
+
+static int cmdOptos() {
+  printf("%-6s %-8s %12s %10s %10s %6s  %s\n", "opto", "beam", "blocked ms", "edges", "edges/win", "idle", "faults");
+  for (uint8_t i = 0; i < OPTO_COUNT; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_OPTO, &i, 1, &p);
+    if (len < 13) return 1;
+    printf("%-6s %-8s %12u %10u %10u %6u  %s\n", optoNames[i], p[0] ? "blocked" : "clear", get32(p + 2),
+           get32(p + 6), get16(p + 10), p[12], faultText(p[1]));
+  }
+  return 0;
+}
+
+static int cmdTasks() {
+  uint8_t tasks = 1;
+  for (uint8_t i = 0; i < tasks; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_TASK, &i, 1, &p);
+    if (len < 23) return 1;
+    if (i == 0) {
+      if (!p[0]) {
+        printf("not running the cyclic executive (threads)\n");
+        return 0;
+      }
+      printf("minor frame %u us x %u, frames %u, overruns %u (%u frames skipped), longest frame %u us\n",
+             get32(p + 2), p[6], get32(p + 7), get32(p + 11), get32(p + 15), get32(p + 19));
+      printf("%-12s %6s %6s %10s %8s %8s  (us)\n", "task", "offset", "period", "runs", "last", "worst");
+      tasks = p[1];
+      if (!tasks) break;
+    }
+    if (len < 37) return 1;
+    printf("%-12.*s %6u %6u %10u %8u %8u\n", len - 37, p + 37, p[23], p[24], get32(p + 25), get32(p + 29),
+           get32(p + 33));
+  }
+  return 0;
+}
+
+#define THREADS_SAMPLE_MS 1000
+
+// Reads every thread into 'rows' (THREAD_MONITOR_MAX of TM_MAX_PAYLOAD bytes); -1 on error
+static int readThreads(uint8_t rows[][TM_MAX_PAYLOAD], int *lens) {
+  uint8_t count = 1;
+  for (uint8_t i = 0; i < count && i < THREAD_MONITOR_MAX; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_THREADS, &i, 1, &p);
+    if (len < 1) return -1;
+    count = p[0];
+    if (i >= count) break;
+    if (len < 30) return -1;
+    memcpy(rows[i], p, len);
+    lens[i] = len;
+  }
+  return count < THREAD_MONITOR_MAX ? count : THREAD_MONITOR_MAX;
+}
+
+static int cmdThreads() {
+  static const char *threadStates[] = { "empty", "running", "ended", "ending", "suspended" };
+  static const char *waitNames[] = { "-", "delay", "join", "mutex", "message" };
+  static uint8_t first[THREAD_MONITOR_MAX][TM_MAX_PAYLOAD], rows[THREAD_MONITOR_MAX][TM_MAX_PAYLOAD];
+  int firstLens[THREAD_MONITOR_MAX], lens[THREAD_MONITOR_MAX];
+
+  // CPU use is each thread's share of the cycles counted between two reads
+  int nfirst = readThreads(first, firstLens);
+  if (nfirst < 0) return 1;
+  usleep(THREADS_SAMPLE_MS * 1000);
+  int n = readThreads(rows, lens);
+  if (n < 0) return 1;
+  if (n == 0) {
+    printf("(not available)\n");
+    return 0;
+  }
+
+  uint64_t delta[THREAD_MONITOR_MAX], total = 0;
+  for (int i = 0; i < n; i++) {
+    delta[i] = get64(rows[i] + 18);
+    for (int j = 0; j < nfirst; j++) {
+      // the same thread only if the slot was not reused in between
+      if (first[j][1] == rows[i][1] && get32(first[j] + 6) == get32(rows[i] + 6)) delta[i] -= get64(first[j] + 18);
+    }
+    total += delta[i];
+  }
+
+  printf("%-3s %-12s %-9s %-7s %4s %5s %10s %8s %8s %6s %12s\n", "id", "name", "state", "wait", "prio",
+         "slice", "created", "stack", "peak", "cpu", "cpu time");
+  for (int i = 0; i < n; i++) {
+    const uint8_t *p = rows[i];
+    uint32_t cpu = get32(p + 26) ? get32(p + 26) : 1;
+    printf("%-3u %-12.*s %-9s %-7s %4u %5u %8u s %8u %8u %5.1f%% %10.3f s\n", p[1], lens[i] - 30, p + 30,
+           p[2] < 5 ? threadStates[p[2]] : "?", p[3] < 5 ? waitNames[p[3]] : "?", p[4], p[5], get32(p + 6) / 1000,
+           get32(p + 10), get32(p + 14), total ? 100.0 * delta[i] / total : 0.0, get64(p + 18) / 1e6 / cpu);
+  }
+  return 0;
+}
+
+static int cmdIrqs() {
+  printf("%-12s %4s %8s %10s %10s %12s %8s\n", "source", "prio", "budget", "runs", "max run", "max latency",
+         "over");
+  uint8_t sources = 1;
+  for (uint8_t i = 0; i < sources; i++) {
+    const uint8_t *p;
+    int len = request(TM_GET_IRQ, &i, 1, &p);
+    if (len < 1) return 1;
+    sources = p[0];
+    if (i >= sources) break;
+    if (len < 21) return 1;
+    uint16_t budget = get16(p + 2);
+    printf("%-12.*s %4u ", len - 21, p + 21, p[1]);
+    if (!budget) {
+      printf("%8s\n", "-");
+      continue;
+    }
+    // port sources have no edge timestamp: their latency is a bound (irq.h)
+    char latency[24];
+    snprintf(latency, sizeof(latency), "%s%.1f us", p[20] ? "" : "<= ", get32(p + 12) / 1000.0);
+    printf("%5u us %10u %7.1f us %12s %8u\n", budget, get32(p + 4), get32(p + 8) / 1000.0, latency,
+           get32(p + 16));
+  }
+  return 0;
+}
+
+static int cmdSelfTest(uint8_t action) {
+  static const char *inputNames[SELFTEST_INPUT_COUNT] = SELFTEST_INPUT_NAMES;
+  static const char *stepNames[SELFTEST_STEP_COUNT] = { "ball gate", "ticket", "credit counter", "displays" };
+  uint8_t inputs = 1;
+  for (uint8_t i = 0; i < inputs; i++) {
+    uint8_t body[2] = { i == 0 ? action : (uint8_t)TM_SELFTEST_QUERY, i };
+    const uint8_t *p;
+    int len = request(TM_SELF_TEST, body, 2, &p);
+    if (len < 3) return 1;
+    if (i == 0) {
+      printf("self-test %s", p[0] ? "running" : "stopped");
+      if (p[0]) printf(", step %s", p[1] < SELFTEST_STEP_COUNT ? stepNames[p[1]] : "?");
+      printf("\n%-8s %8s %10s %10s %10s %10s  (us)\n", "input", "edges", "last", "min", "avg", "max");
+      inputs = p[2];
+    }
+    if (len < 27) return 1;
+    uint32_t count = get32(p + 3);
+    printf("%-8s %8u", i < SELFTEST_INPUT_COUNT ? inputNames[i] : "?", count);
+    if (count) printf(" %10u %10u %10u %10u", get32(p + 7), get32(p + 11), (uint32_t)(get64(p + 19) / count), get32(p + 15));
+    printf("\n");
+  }
+  return 0;
+}
+
+// Transit (ms) below which 'pct' percent of the distribution lies, to bucket resolution
+static double distributionPercentile(const uint8_t *counts, uint8_t n, uint32_t bucketUs, int pct) {
+  unsigned seen = 0;
+  for (int i = 0; i < SHOT_BUCKETS; i++) {
+    seen += counts[i];
+    if (seen * 100 >= (unsigned)n * pct) return (i + 1) * bucketUs / 1e3;
+  }
+  return SHOT_BUCKETS * bucketUs / 1e3;
+}
+
+static int cmdShots() {
+  static const char *kindNames[SHOTS_KIND_COUNT] = { "game", "last game", "lifetime" };
+  uint8_t r[SHOTS_KIND_COUNT][64];
+  const uint8_t *p = 0;
+  for (uint8_t kind = 0; kind < SHOTS_KIND_COUNT; kind++) {
+    int len = request(TM_GET_SHOTS, &kind, 1, &p);
+    if (len < 31 + SHOT_BUCKETS) return 1;
+    memcpy(r[kind], p, len);
+  }
+
+  printf("%-16s", "");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10s", kindNames[k]);
+  printf("\n%-16s", "baskets");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10u", get16(r[k]));
+  printf("\n%-16s", "misses");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10u", get16(r[k] + 2));
+  printf("\n%-16s", "swishes");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10u", get16(r[k] + 4));
+  printf("\n%-16s", "best streak");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10u", get16(r[k] + 6));
+  printf("\n%-16s", "transit min ms");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10.1f", get32(r[k] + 8) / 1e3);
+  printf("\n%-16s", "transit avg ms");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) {
+    uint16_t baskets = get16(r[k]);
+    printf(" %10.1f", baskets ? get64(r[k] + 16) / 1e3 / baskets : 0.0);
+  }
+  printf("\n%-16s", "transit max ms");
+  for (int k = 0; k < SHOTS_KIND_COUNT; k++) printf(" %10.1f", get32(r[k] + 12) / 1e3);
+  printf("\n\nstreak now %u\n", get16(r[0] + 24));
+
+  uint32_t bucketUs = get32(r[0] + 26);
+  uint8_t n = r[0][30];
+  const uint8_t *counts = r[0] + 31;
+  printf("last %u transits:", n);
+  if (n) {
+    printf(" median < %.0f ms, 90%% < %.0f ms", distributionPercentile(counts, n, bucketUs, 50),
+           distributionPercentile(counts, n, bucketUs, 90));
+  }
+  printf("\n");
+  for (int i = 0; i < SHOT_BUCKETS; i++) {
+    if (i < SHOT_BUCKETS - 1) printf("  %4u-%-4u ms %3u ", i * bucketUs / 1000, (i + 1) * bucketUs / 1000, counts[i]);
+    else printf("  %4u+     ms %3u ", i * bucketUs / 1000, counts[i]);
+    for (int j = 0; j < counts[i]; j++) putchar('#');
+    putchar('\n');
+  }
+  return 0;
+}
+
+static int cmdConfig() {
+  const uint8_t *p;
+  int len = request(TM_GET_CONFIG, 0, 0, &p);
+  if (len < CFG_COUNT) return 1;
+  for (int i = 0; i < CFG_COUNT; i++) printf("%-18s %u\n", settingNames[i], p[i]);
+  return 0;
+}
+
+static int cmdSet(const char *name, const char *value) {
+  int field = lookup(name, settingNames, CFG_COUNT);
+  if (field < 0) {
+    fprintf(stderr, "hsctl: unknown setting '%s'\n", name);
+    return 1;
+  }
+  uint8_t body[2] = { (uint8_t)field, (uint8_t)atoi(value) };
+  const uint8_t *p;
+  return request(TM_SET_CONFIG, body, 2, &p) < 0;
+}
+
+static int cmdTest(const char *name, const char *arg) {
+  int output = lookup(name, outputNames, TM_OUT_COUNT);
+  if (output < 0) {
+    fprintf(stderr, "hsctl: unknown output '%s'\n", name);
+    return 1;
+  }
+  unsigned v = atoi(arg);
+  uint8_t body[3] = { (uint8_t)output, (uint8_t)v, (uint8_t)(v >> 8) };
+  const uint8_t *p;
+  return request(TM_TEST_OUTPUT, body, 3, &p) < 0;
+}
+
+static void onSignal(int) {
+  stop = 1;
+}
+
+static int cmdMonitor(int argc, char **argv) {
+  const int nevents = sizeof(eventNames) / sizeof(eventNames[0]);
+  uint8_t mask = argc ? 0 : (1 << nevents) - 1;
+  for (int i = 0; i < argc; i++) {
+    int e = lookup(argv[i], eventNames, nevents);
+    if (e < 0) {
+      fprintf(stderr, "hsctl: unknown event '%s'\n", argv[i]);
+      return 1;
+    }
+    mask |= 1 << e;
+  }
+
+  const uint8_t *p;
+  if (request(TM_STREAM, &mask, 1, &p) < 0) return 1;
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  showText = true;
+  setvbuf(stdout, 0, _IOLBF, 0);
+
+  int lastSeq = -1;
+  while (!stop) {
+    int len = readFrame(1000);
+    if (len < 0) return 1;
+    const uint8_t *f = rx.data();
+    if (len < 11 || f[0] != TM_EVENT) continue;
+    if (lastSeq >= 0 && f[1] != (uint8_t)(lastSeq + 1)) printf("# %u events dropped\n", (uint8_t)(f[1] - lastSeq - 1));
+    lastSeq = f[1];
+
+    uint32_t ms = get32(f + 3);
+    uint16_t a = get16(f + 7), b = get16(f + 9);
+    printf("[%10.3f] ", ms / 1e3);
+    switch (f[2]) {
+      case TM_EV_STATE: printf("state %s\n", stateName(a)); break;
+      case TM_EV_CREDIT: printf("credits %u\n", a); break;
+      case TM_EV_TICK: printf("%u s left\n", a); break;
+      case TM_EV_GAME_OVER: printf("game over, score %u, tickets %u\n", a, b); break;
+      case TM_EV_FAULT: printf("opto %s faults %s\n", a < OPTO_COUNT ? optoNames[a] : "?", faultText(b)); break;
+      case TM_EV_SUPPLY: printf("supply faults %s, 12V %u mV\n", supplyFaultText(a), b); break;
+      default: printf("event %u %u %u\n", f[2], a, b); break;
+    }
+  }
+
+  uint8_t off = 0;
+  showText = false;
+  stop = 0;
+  request(TM_STREAM, &off, 1, &p);
+  return 0;
+}
+
+static int cmdCrash(bool clear) {
+  uint8_t body = clear;
+  const uint8_t *p;
+  showText = true; // the dump arrives as text ahead of the response
+  int len = request(TM_CRASH_REPORT, &body, 1, &p);
+  if (len < 1) return 1;
+  if (!p[0]) printf("no crash recorded\n");
+  return 0;
+}
+
+static int cmdRecord(uint32_t from) {
+  uint32_t index = from, count = 0;
+  bool first = true;
+  do {
+    uint8_t body[4] = { (uint8_t)index, (uint8_t)(index >> 8), (uint8_t)(index >> 16), (uint8_t)(index >> 24) };
+    const uint8_t *p;
+    int len = request(TM_RECORD_READ, body, 4, &p);
+    if (len < 9) return 1;
+    if (first) {
+      count = get32(p); // events recorded after this are left for the next dump
+      uint32_t oldest = get32(p + 4);
+      if (index < oldest) index = oldest;
+      printf("%s\n# events %u to %u, %u overwritten\n", RECORD_TEXT_HEADER, index, count, oldest);
+      first = false;
+    }
+    uint8_t n = p[8];
+    if (n == 0) break;
+    for (uint8_t i = 0; i < n && index < count; i++, index++) {
+      const uint8_t *e = p + 9 + i * 8;
+      printf("%u %s %u %u\n", get32(e), e[4] < REC_TYPE_COUNT ? recordTypeNames[e[4]] : "?", e[5], get16(e + 6));
+    }
+  } while (index < count);
+  return 0;
+}
+
+static int cmdReplay(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+
+  const uint8_t *p;
+  uint8_t on = 1, off = 0;
+  uint8_t end[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+  if (request(TM_RECORD_READ, end, 4, &p) < 9) {
+    fclose(f);
+    return 1;
+  }
+  uint32_t from = get32(p);
+  if (request(TM_REPLAY, &on, 1, &p) < 0) {
+    fclose(f);
+    return 1;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  char line[128], name[16];
+  unsigned long us;
+  unsigned id, value, injected = 0;
+  int64_t t0 = -1;
+  int rc = 0;
+  while (!stop && fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || sscanf(line, "%lu %15s %u %u", &us, name, &id, &value) != 4) continue;
+    int type = lookup(name, recordTypeNames, REC_TYPE_COUNT);
+    if (type != REC_CONFIG && type != REC_COIN && type != REC_OPTO) continue;
+    if (t0 < 0) t0 = us;
+
+    // pace the inputs as recorded, relative to the first one
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed = (now.tv_sec - start.tv_sec) * 1000000LL + (now.tv_nsec - start.tv_nsec) / 1000;
+    int64_t due = (int64_t)(uint32_t)(us - t0);
+    if (due > elapsed) usleep(due - elapsed);
+
+    uint8_t body[4] = { (uint8_t)type, (uint8_t)id, (uint8_t)value, (uint8_t)(value >> 8) };
+    if (request(TM_INJECT, body, 4, &p) < 0) {
+      rc = 1;
+      break;
+    }
+    injected++;
+  }
+  fclose(f);
+
+  // inputs that fail mid-game leave the cabinet in replay mode; always release it
+  stop = 0;
+  request(TM_REPLAY, &off, 1, &p);
+  fprintf(stderr, "injected %u inputs; hsctl record %u shows the replay\n", injected, from);
+  return rc;
+}
+
+static int usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [-d device] [-t timeout-ms] command [args]\n"
+          "  ping | counters | probes | reset-probes | pools | memory | boot | link | optos | supply\n"
+          "  selftest [start|stop]\n"
+          "  shots | irqs | tasks | threads\n"
+          "  config\n"
+          "  set <high-score|tickets-per-score|plays-per-credit|play-time|attract-time> <value>\n"
+          "  test <ball-gate|ticket-counter|credit-counter> <ms> | test tickets <count>\n"
+          "  monitor [state|credit|tick|game-over|fault|supply...]\n"
+          "  crash [clear] | record [from] | replay <file>\n",
+          prog);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  const char *device = getenv("HOTSHOT_PORT");
+  if (!device) device = "/dev/ttyACM0";
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:t:h")) != -1) {
+    switch (opt) {
+      case 'd': device = optarg; break;
+      case 't': timeoutMs = atoi(optarg); break;
+      default: return usage(argv[0]);
+    }
+  }
+  if (optind >= argc) return usage(argv[0]);
+
+  const char *cmd = argv[optind];
+  int nargs = argc - optind - 1;
+  char **args = argv + optind + 1;
+
+  if (openPort(device) != 0) return 1;
+
+  if (strcmp(cmd, "ping") == 0) return cmdPing();
+  if (strcmp(cmd, "counters") == 0) return cmdCounters();
+  if (strcmp(cmd, "probes") == 0) return cmdProbes();
+  if (strcmp(cmd, "pools") == 0) return cmdPools();
+  if (strcmp(cmd, "memory") == 0) return cmdMemory();
+  if (strcmp(cmd, "boot") == 0) return cmdBoot();
+  if (strcmp(cmd, "link") == 0) return cmdLink();
+  if (strcmp(cmd, "shots") == 0) return cmdShots();
+  if (strcmp(cmd, "optos") == 0) return cmdOptos();
+  if (strcmp(cmd, "supply") == 0) return cmdSupply();
+  if (strcmp(cmd, "irqs") == 0) return cmdIrqs();
+  if (strcmp(cmd, "tasks") == 0) return cmdTasks();
+  if (strcmp(cmd, "threads") == 0) return cmdThreads();
+  if (strcmp(cmd, "selftest") == 0) {
+    if (nargs && strcmp(args[0], "start") == 0) return cmdSelfTest(TM_SELFTEST_START);
+    if (nargs && strcmp(args[0], "stop") == 0) return cmdSelfTest(TM_SELFTEST_STOP);
+    return cmdSelfTest(TM_SELFTEST_QUERY);
+  }
+  if (strcmp(cmd, "config") == 0) return cmdConfig();
+  if (strcmp(cmd, "monitor") == 0) return cmdMonitor(nargs, args);
+  if (strcmp(cmd, "crash") == 0) return cmdCrash(nargs && strcmp(args[0], "clear") == 0);
+  if (strcmp(cmd, "record") == 0) return cmdRecord(nargs ? strtoul(args[0], 0, 0) : 0);
+  if (strcmp(cmd, "replay") == 0 && nargs == 1) return cmdReplay(args[0]);
+  if (strcmp(cmd, "reset-probes") == 0) {
+    const uint8_t *p;
+    return request(TM_RESET_PROBES, 0, 0, &p) < 0;
+  }
+  if (strcmp(cmd, "set") == 0 && nargs == 2) return cmdSet(args[0], args[1]);
+  if (strcmp(cmd, "test") == 0 && nargs == 2) return cmdTest(args[0], args[1]);
+  return usage(argv[0]);
+}
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+symbolize.py - annotate a crash dump (src/crash.h) with functions and source lines.
+
+usage: symbolize.py [--addr2line PATH] firmware.elf [log]
+
+Reads the serial log (or stdin) and copies it to stdout. Inside each
+'*** CRASH' ... '*** END CRASH' block, every word that looks like a code
+address (within flash; stack words must also have the Thumb bit set) is
+resolved with addr2line against the ELF and listed after the line. Use the
+ELF the cabinet was flashed with; any other build gives wrong answers.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+FLASH_END = 0x40000  # MK20DX256: 256 KB of flash from address 0
+WORD = re.compile(r"0x([0-9a-fA-F]{8})")
+
+
+def code_address(value, thumb_only):
+    if thumb_only and not value & 1:
+        return None
+    value &= ~1
+    return value if 0 < value < FLASH_END else None
+
+
+def addresses_in(line):
+    """Code addresses worth resolving in one report line, in order."""
+    body = line.strip()
+    if body.startswith("pc") or body.startswith("r0"):
+        # registers: pc, and lr when it is a return address rather than EXC_RETURN
+        words = {}
+        for name, value in re.findall(r"(\w+)\s+0x([0-9a-fA-F]{8})", body):
+            words[name] = int(value, 16)
+        out = []
+        if "pc" in words:
+            out.append(("pc", code_address(words["pc"], False)))
+        if "lr" in words:
+            out.append(("lr", code_address(words["lr"], True)))
+        return [(n, a) for n, a in out if a is not None]
+    if body.startswith("stack"):
+        values = [int(v, 16) for v in WORD.findall(body)[1:]]  # first word is the address
+        return [("stack", a) for a in (code_address(v, True) for v in values) if a is not None]
+    return []
+
+
+def resolve(addr2line, elf, addresses):
+    if not addresses:
+        return {}
+    cmd = [addr2line, "-e", elf, "-f", "-C", "-i", "-p"] + ["0x%x" % a for a in addresses]
+    try:
+        out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit("symbolize.py: %s: %s" % (addr2line, e))
+
+    # -i prints inlined frames as extra " (inlined by) ..." lines after the address's first line
+    result, lines = {}, out.splitlines()
+    i = 0
+    for a in addresses:
+        frames = [lines[i]] if i < len(lines) else ["??"]
+        i += 1
+        while i < len(lines) and lines[i].lstrip().startswith("(inlined by)"):
+            frames.append(lines[i].strip())
+            i += 1
+        result[a] = frames
+    return result
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Annotate HotShot crash dumps with source locations.")
+    ap.add_argument("--addr2line", default=os.environ.get("ADDR2LINE", "arm-none-eabi-addr2line"))
+    ap.add_argument("elf")
+    ap.add_argument("log", nargs="?")
+    args = ap.parse_args()
+
+    text = open(args.log, errors="replace").read() if args.log else sys.stdin.read()
+    lines = text.splitlines()
+
+    # resolve everything in one addr2line run
+    wanted, in_dump = [], False
+    for line in lines:
+        if line.startswith("*** CRASH"):
+            in_dump = True
+        elif line.startswith("*** END CRASH"):
+            in_dump = False
+        elif in_dump:
+            wanted += [a for _, a in addresses_in(line) if a not in wanted]
+    names = resolve(args.addr2line, args.elf, wanted)
+
+    in_dump = False
+    for line in lines:
+        print(line)
+        if line.startswith("*** CRASH"):
+            in_dump = True
+        elif line.startswith("*** END CRASH"):
+            in_dump = False
+        elif in_dump:
+            for label, a in addresses_in(line):
+                frames = names.get(a, ["??"])
+                print("      %-5s 0x%08x  %s" % (label, a, frames[0]))
+                for f in frames[1:]:
+                    print("                        %s" % f)
+
+
+if __name__ == "__main__":
+    main()